@@ -17,24 +17,29 @@ int main() {
         return 1;
     }
 
-    
-
-    // Main loop
-    while (SEventProcess(&app)) {
-        // Begin frame
-        SBeginFrame(&app);
-        
-        
-        SDrawText(&app, "OpenGL Text Rendering Demo", 10, SGetCurrentWindowHeight(&app) - 30, 2.0f, 1.0f, 1.0f, 1.0f);
-      
-
-        SDrawTriangle(&app, blue, 100.0f, 150.0f, 50.0f);   
-        SDrawRectangle(&app, red, 200.0f, 150.0f, 40.0f, 40.0f);  
-        SDrawCircle(&app, green, 300.0f, 150.0f, 25.0f); 
-        SDrawImage("docs/images/image.png", 1920, 1080, 0.5, -0.5);
+    // Decoded and uploaded once, every frame only draws a quad.
+    SImage* image = SLoadImage("docs/images/image.png");
+
+    // Main loop, sleeps until input arrives or a second has passed.
+    while (SWaitEvents(&app, 1.0)) {
+        if (!SNeedsRedraw(&app)) {
+            continue;
+        }
+
+        // Begin frame, false while the window is minimized or covered and nothing would be seen.
+        if (SBeginFrame(&app)) {
+            SDrawText(&app, "OpenGL Text Rendering Demo", 10, SGetCurrentWindowHeight(&app) - 30, 2.0f, 1.0f, 1.0f, 1.0f);
+
+            SDrawTriangle(&app, blue, 100.0f, 150.0f, 50.0f);   
+            SDrawRectangle(&app, red, 200.0f, 150.0f, 40.0f, 40.0f);  
+            SDrawCircle(&app, green, 300.0f, 150.0f, 25.0f); 
+            SDrawImageHandle(&app, image, 200.0f, 150.0f, 200.0f, 150.0f);
+        }
         // End frame
         SSwapBuffers(&app);
     }
 
+    SReleaseImage(image);
+    SDisplayClose(&app);
     return 0;
 }
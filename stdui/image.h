@@ -3,31 +3,54 @@
 //Copyright (C) <2025>  <Wickslynx>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <stdbool.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/stat.h>
 
 #ifndef WIDGETS_H
 #include "widgets.h"
 #endif
 
+// An image file decoded and uploaded once, see SLoadImage(). Handles are shared: loading the
+// same unchanged file again returns the same one with another reference.
+typedef struct SImage {
+    char* path;
+    time_t modified;         // mtime of path when it was decoded, a newer file loads as a new image.
+    int refs;
+    int width, height;       // Pixels.
+    unsigned int texture;    // GL texture, 0 until the first draw when loaded without a context.
+    unsigned int generation; // stduiGL.generation the texture belongs to.
+    unsigned char* pixels;   // RGBA rows waiting for the upload, NULL once uploaded.
+    struct SImage* next;
+} SImage;
+
+SImage* SLoadImage(const char* path);
+void SReleaseImage(SImage* image);
+
 #ifndef STDUI_IMAGE_SUPPORT_OFF
+#ifdef STDUI_GLES
+#include <GLES3/gl3.h>
+#else
 #include <GL/gl.h>
+#endif
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "internal/stb_image.h"
 
 
+// What SDrawImage() draws, the image stays in the cache between calls.
 typedef struct {
-    GLuint textureID;
-    GLuint VAO;
-    GLuint VBO;
-    GLuint EBO;
-    GLuint shaderProgram;
+    SImage* image;
+    float posX, posY;        // Center in normalized device coordinates, the quad is one unit wide.
 } ImageRenderer;
 
 
 unsigned char* loadImage(const char* filename, int* width, int* height, int* channels);
-ImageRenderer* createImageRenderer(const char* filename, int width, int height, float posX, float posY);
+ImageRenderer* createImageRenderer(const char* filename, float posX, float posY);
 void SDrawImage(const char* filename, int width, int height, float posX, float posY);
+void SDrawImageHandle(SApplication* app, SImage* image, float x, float y, float width, float height);
 void renderImage(ImageRenderer* renderer);
 void destroyImageRenderer(ImageRenderer* renderer);
 
@@ -36,21 +59,29 @@ extern ImageRenderer* imageRenderer;
 // Fixed: Added proper initialization in the implementation section
 ImageRenderer* imageRenderer = NULL;
 
+// Every image loaded and still referenced, most recent first.
+static SImage* imageCache = NULL;
+// One program for every image, the quad comes from gl_VertexID like the text grid's.
+static GLuint imageProgram = 0;
+static unsigned int imageProgramGeneration = 0;
+static GLint imageProjectionLoc, imageOriginLoc, imageSizeLoc;
+
 // Vertex shader
-const char* vertexShaderSource = 
-    "#version 330 core\n"
-    "layout (location = 0) in vec3 aPos;\n"
-    "layout (location = 1) in vec2 aTexCoord;\n"
+const char* vertexShaderSource =
+    STDUI_GLSL_VERSION
     "out vec2 TexCoord;\n"
+    "uniform mat4 projection;\n"
+    "uniform vec2 origin;\n"
+    "uniform vec2 size;\n"
     "void main()\n"
     "{\n"
-    "    gl_Position = vec4(aPos, 1.0);\n"
-    "    TexCoord = aTexCoord;\n"
+    "    TexCoord = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    gl_Position = projection * vec4(origin + TexCoord * size, 0.0, 1.0);\n"
     "}\0";
 
 // Fragment shader
-const char* fragmentShaderSource = 
-    "#version 330 core\n"
+const char* fragmentShaderSource =
+    STDUI_GLSL_VERSION
     "out vec4 FragColor;\n"
     "in vec2 TexCoord;\n"
     "uniform sampler2D texture1;\n"
@@ -59,9 +90,10 @@ const char* fragmentShaderSource =
     "    FragColor = texture(texture1, TexCoord);\n"
     "}\0";
 
+// Decode to RGBA with the first row at the top, the order the quads sample it in.
 unsigned char* loadImage(const char* filename, int* width, int* height, int* channels) {
-    stbi_set_flip_vertically_on_load(true);  // Flip image vertically for OpenGL
-    unsigned char* data = stbi_load(filename, width, height, channels, 0);
+    stbi_set_flip_vertically_on_load(false);
+    unsigned char* data = stbi_load(filename, width, height, channels, 4);
     if (!data) {
         fprintf(stderr, "Failed to load image: %s\n", filename);
     }
@@ -75,12 +107,12 @@ unsigned char* loadImage(const char* filename, int* width, int* height, int* cha
 static GLuint createImageShaderProgram() {
     GLuint vertexShader = compileShader(vertexShaderSource, GL_VERTEX_SHADER);
     GLuint fragmentShader = compileShader(fragmentShaderSource, GL_FRAGMENT_SHADER);
-    
+
     GLuint shaderProgram = glCreateProgram();
     glAttachShader(shaderProgram, vertexShader);
     glAttachShader(shaderProgram, fragmentShader);
     glLinkProgram(shaderProgram);
-    
+
     // Check for linking errors
     GLint success;
     char infoLog[512];
@@ -89,106 +121,260 @@ static GLuint createImageShaderProgram() {
         glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
         fprintf(stderr, "ERROR::SHADER::PROGRAM::LINKING_FAILED\n%s\n", infoLog);
     }
-    
+
     // Delete shaders as they're linked into our program and no longer necessary
     glDeleteShader(vertexShader);
     glDeleteShader(fragmentShader);
-    
+
     return shaderProgram;
 }
 
-ImageRenderer* createImageRenderer(const char* filename, int width, int height, float posX, float posY) {
-    ImageRenderer* renderer = (ImageRenderer*)malloc(sizeof(ImageRenderer));
-    if (!renderer) return NULL;
+static time_t imageModified(const char* path) {
+    struct stat info;
+    return stat(path, &info) == 0 ? info.st_mtime : 0;
+}
 
-    int channels;
-    unsigned char* data = loadImage(filename, &width, &height, &channels);
-    if (!data) {
-        free(renderer);
-        return NULL;
+// Upload the decoded pixels into a texture of the current share group. The pixels are freed
+// afterwards, an image that outlives every window is decoded again for the next ones.
+static bool uploadImage(SImage* image) {
+    if (image->pixels == NULL) {
+        int channels;
+        image->pixels = loadImage(image->path, &image->width, &image->height, &channels);
+        if (image->pixels == NULL) {
+            return false;
+        }
     }
 
-    // Create texture
-    glGenTextures(1, &renderer->textureID);
-    glBindTexture(GL_TEXTURE_2D, renderer->textureID);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    GLint prevTexture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTexture);
+    glGenTextures(1, &image->texture);
+    glBindTexture(GL_TEXTURE_2D, image->texture);
+    if (stduiGL.textureStorage) {
+        stduiGL.TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, image->width, image->height);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, image->width, image->height, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, image->width, image->height, 0, GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexImage2D(GL_TEXTURE_2D, 0, channels == 4 ? GL_RGBA : GL_RGB, width, height, 0,
-                 channels == 4 ? GL_RGBA : GL_RGB, GL_UNSIGNED_BYTE, data);
-    stbi_image_free(data);
-
-    // Create shader program - updated to use the renamed function
-    renderer->shaderProgram = createImageShaderProgram();
-
-    // Vertex data with dynamic position
-    float vertices[] = {
-        // positions                  // texture coords
-        posX - 0.5f, posY - 0.5f, 0.0f,  0.0f, 0.0f,  // bottom left
-        posX + 0.5f, posY - 0.5f, 0.0f,  1.0f, 0.0f,  // bottom right
-        posX + 0.5f, posY + 0.5f, 0.0f,  1.0f, 1.0f,  // top right
-        posX - 0.5f, posY + 0.5f, 0.0f,  0.0f, 1.0f   // top left
-    };
-    unsigned int indices[] = {
-        0, 1, 2,  // first triangle
-        2, 3, 0   // second triangle
-    };
+    glBindTexture(GL_TEXTURE_2D, prevTexture);
+
+    stbi_image_free(image->pixels);
+    image->pixels = NULL;
+    image->generation = stduiGL.generation;
+    return true;
+}
+
+// The texture of the current share group, uploading it on first use. 0 if the file is gone.
+static GLuint imageTexture(SImage* image) {
+    if (image->texture != 0 && image->generation == stduiGL.generation) {
+        return image->texture;
+    }
+    image->texture = 0; // Deleted with the contexts it was made in.
+    return uploadImage(image) ? image->texture : 0;
+}
+
+// Return a handle to the image at path, decoding it only if the cache has no copy of the file
+// as it is on disk now. Release it with SReleaseImage(). NULL if the file cannot be decoded.
+// The texture is uploaded here when a window exists, otherwise on the first draw.
+SImage* SLoadImage(const char* path) {
+    if (path == NULL) {
+        return NULL;
+    }
+
+    time_t modified = imageModified(path);
+    for (SImage* image = imageCache; image; image = image->next) {
+        if (image->modified == modified && strcmp(image->path, path) == 0) {
+            image->refs++;
+            return image;
+        }
+    }
+
+    SImage* image = (SImage*)calloc(1, sizeof(SImage));
+    size_t length = strlen(path) + 1;
+    char* copy = (char*)malloc(length);
+    if (!image || !copy) {
+        free(image);
+        free(copy);
+        fprintf(stderr, "ERROR: Out of memory loading image %s\n", path);
+        return NULL;
+    }
+    memcpy(copy, path, length);
+    image->path = copy;
+    image->modified = modified;
+
+    int channels;
+    image->pixels = loadImage(path, &image->width, &image->height, &channels);
+    if (image->pixels == NULL) {
+        free(image->path);
+        free(image);
+        return NULL;
+    }
+    if (stduiGL.loaded) {
+        uploadImage(image);
+    }
 
-    // Create buffers
-    glGenVertexArrays(1, &renderer->VAO);
-    glGenBuffers(1, &renderer->VBO);
-    glGenBuffers(1, &renderer->EBO);
+    // An older copy of the file stays cached until its last reference goes.
+    image->refs = 1;
+    image->next = imageCache;
+    imageCache = image;
+    return image;
+}
+
+// Drop a reference from SLoadImage(). The last one deletes the texture, a window of the share
+// group must be current then.
+void SReleaseImage(SImage* image) {
+    if (image == NULL || --image->refs > 0) {
+        return;
+    }
 
-    glBindVertexArray(renderer->VAO);
+    for (SImage** link = &imageCache; *link; link = &(*link)->next) {
+        if (*link == image) {
+            *link = image->next;
+            break;
+        }
+    }
+    if (image->texture != 0 && image->generation == stduiGL.generation && stduiGL.loaded) {
+        glDeleteTextures(1, &image->texture);
+    }
+    if (image->pixels) {
+        stbi_image_free(image->pixels);
+    }
+    free(image->path);
+    free(image);
+}
+
+// Called by SCleanupRenderer() with the last context of the share group current: the program
+// goes with it and so does the image SDrawImage() kept.
+static void cleanupImages(void) {
+    destroyImageRenderer(imageRenderer);
+    imageRenderer = NULL;
+    if (imageProgram != 0 && imageProgramGeneration == stduiGL.generation) {
+        glDeleteProgram(imageProgram);
+    }
+    imageProgram = 0;
+    cleanupImageRenderer = NULL;
+}
+
+// One textured quad with its corner at origin, in whatever space projection maps from.
+static void drawImageQuad(SImage* image, const GLfloat projection[16], float x, float y, float width, float height) {
+    GLuint texture = imageTexture(image);
+    if (texture == 0 || textVAO == 0) {
+        return;
+    }
+    if (imageProgram == 0 || imageProgramGeneration != stduiGL.generation) {
+        imageProgram = createImageShaderProgram();
+        imageProgramGeneration = stduiGL.generation;
+        imageProjectionLoc = glGetUniformLocation(imageProgram, "projection");
+        imageOriginLoc = glGetUniformLocation(imageProgram, "origin");
+        imageSizeLoc = glGetUniformLocation(imageProgram, "size");
+        glUseProgram(imageProgram);
+        glUniform1i(glGetUniformLocation(imageProgram, "texture1"), 0);
+        cleanupImageRenderer = cleanupImages;
+    }
+
+    // Like the shapes nothing is saved, the quad binds what it needs and blends the way every
+    // window set up.
+    glUseProgram(imageProgram);
+    glUniformMatrix4fv(imageProjectionLoc, 1, GL_FALSE, projection);
+    glUniform2f(imageOriginLoc, x, y);
+    glUniform2f(imageSizeLoc, width, height);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    // Any VAO will do, the vertices come from gl_VertexID.
+    glBindVertexArray(textVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glBindVertexArray(0);
+}
 
-    glBindBuffer(GL_ARRAY_BUFFER, renderer->VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+// Draw an image from SLoadImage() with its top left corner at (x, y), stretched to width by
+// height pixels. Only the quad is drawn, the pixels were uploaded once.
+void SDrawImageHandle(SApplication* app, SImage* image, float x, float y, float width, float height) {
+    if (image == NULL || drawsDropped(app)) {
+        return;
+    }
 
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer->EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(indices), indices, GL_STATIC_DRAW);
+    GLfloat projection[16] = {
+        2.0f / SGetCurrentWindowWidth(app), 0.0f, 0.0f, 0.0f,
+        0.0f, -2.0f / SGetCurrentWindowHeight(app), 0.0f, 0.0f,
+        0.0f, 0.0f, -1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f
+    };
+    drawImageQuad(image, projection, x, y, width, height);
+}
 
-    // Position attribute
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    // Texture attribute
-    glVertexAttribPointer(1, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+ImageRenderer* createImageRenderer(const char* filename, float posX, float posY) {
+    ImageRenderer* renderer = (ImageRenderer*)malloc(sizeof(ImageRenderer));
+    if (!renderer) return NULL;
 
+    renderer->image = SLoadImage(filename);
+    if (!renderer->image) {
+        free(renderer);
+        return NULL;
+    }
+    renderer->posX = posX;
+    renderer->posY = posY;
+    cleanupImageRenderer = cleanupImages;
     return renderer;
 }
 
 void renderImage(ImageRenderer* renderer) {
     if (!renderer) return;
 
-    glUseProgram(renderer->shaderProgram);
-    glBindTexture(GL_TEXTURE_2D, renderer->textureID);
-    glBindVertexArray(renderer->VAO);
-    glDrawElements(GL_TRIANGLES, 6, GL_UNSIGNED_INT, 0);
+    static const GLfloat identity[16] = {
+        1.0f, 0.0f, 0.0f, 0.0f,
+        0.0f, 1.0f, 0.0f, 0.0f,
+        0.0f, 0.0f, 1.0f, 0.0f,
+        0.0f, 0.0f, 0.0f, 1.0f
+    };
+    // Y points up in device coordinates, the top edge is at posY + 0.5.
+    drawImageQuad(renderer->image, identity, renderer->posX - 0.5f, renderer->posY + 0.5f, 1.0f, -1.0f);
 }
 
+// Draw the image at filename as a one unit quad centered on (posX, posY) in normalized device
+// coordinates. width and height are not used, the quad has the same size for every image.
+// The file is resolved once and kept while it is the one drawn, changes on disk are not seen.
+// Prefer SLoadImage() and SDrawImageHandle() to place images in pixels.
 void SDrawImage(const char* filename, int width, int height, float posX, float posY) {
-    // Fixed: Free existing image renderer before creating a new one
-    if (imageRenderer) {
+    (void)width; (void)height;
+    if (filename == NULL) {
+        return;
+    }
+    if (!imageRenderer || strcmp(imageRenderer->image->path, filename) != 0) {
+        ImageRenderer* next = createImageRenderer(filename, posX, posY);
+        if (!next) {
+            return;
+        }
         destroyImageRenderer(imageRenderer);
-        imageRenderer = NULL;
+        imageRenderer = next;
     }
-    imageRenderer = createImageRenderer(filename, width, height, posX, posY);
+    imageRenderer->posX = posX;
+    imageRenderer->posY = posY;
+    renderImage(imageRenderer);
 }
 
 void destroyImageRenderer(ImageRenderer* renderer) {
     if (!renderer) return;
 
-    glDeleteVertexArrays(1, &renderer->VAO);
-    glDeleteBuffers(1, &renderer->VBO);
-    glDeleteBuffers(1, &renderer->EBO);
-    glDeleteTextures(1, &renderer->textureID);
-    glDeleteProgram(renderer->shaderProgram);
+    SReleaseImage(renderer->image);
     free(renderer);
 }
 
 #else
 
+SImage* SLoadImage(const char* path) {
+    printf("(WARNING) Images is not supported in the vulkan version, will not be rendered.\n");
+    return NULL;
+}
+
+void SReleaseImage(SImage* image) {
+}
+
+void SDrawImageHandle(SApplication* app, SImage* image, float x, float y, float width, float height) {
+}
+
 void SDrawImage(const char* filename, int width, int height, float posX, float posY) {
     printf("(WARNING) Images is not supported in the vulkan version, will not be rendered.\n");
     // Fixed: Added newline character to the warning message
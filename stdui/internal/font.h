@@ -0,0 +1,1336 @@
+#ifndef FONT_H
+#define FONT_H
+//Copyright (C) <2025>  <Wickslynx>
+
+// Glyph cache for the text renderer.
+// Glyphs are rasterized the first time they are used, at the exact pixel size they are drawn at,
+// and packed into atlas pages with a skyline packer. This file only touches CPU memory,
+// the pages are uploaded to the GPU in widgets.h.
+// Optionally glyphs are rasterized by worker threads, see SSetGlyphLoading().
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "stb_truetype.h"
+#include "reserve-font.h"
+#ifndef STDUI_NO_EMBEDDED_FONT
+#include "courier_new_ttf.h"
+#endif
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#if !defined(STDUI_NO_GLYPH_THREADS) && (defined(__unix__) || defined(__APPLE__))
+#define STDUI_GLYPH_THREADS
+#include <pthread.h>
+#endif
+
+#ifndef STDUI_ATLAS_PAGE_SIZE
+#define STDUI_ATLAS_PAGE_SIZE 1024
+#endif
+
+#ifndef STDUI_ATLAS_MAX_PAGES
+#define STDUI_ATLAS_MAX_PAGES 8
+#endif
+
+#define STDUI_MAX_FONTS 16
+#define STDUI_MAX_FONT_SIZES 32
+#define STDUI_GLYPH_PADDING 1
+
+// Distance field glyphs are generated once at this size and scaled to any draw size.
+#ifndef STDUI_SDF_SIZE
+#define STDUI_SDF_SIZE 48
+#endif
+#define STDUI_SDF_PADDING 6
+#define STDUI_SDF_ONEDGE 128
+
+// Glyphs at or below this size are always rasterized right away, larger glyphs that are still
+// being rasterized by a worker can be drawn from this size instead.
+#ifndef STDUI_GLYPH_FALLBACK_SIZE
+#define STDUI_GLYPH_FALLBACK_SIZE 12
+#endif
+#define STDUI_MAX_GLYPH_WORKERS 8
+#define STDUI_GLYPH_QUEUE_SIZE 1024
+
+// What a draw does with a glyph that has not been rasterized yet.
+typedef enum {
+    SGLYPH_LOAD_BLOCK,    // Rasterize it on the calling thread before drawing (default).
+    SGLYPH_LOAD_SKIP,     // Rasterize it on a worker and draw nothing until it is ready.
+    SGLYPH_LOAD_FALLBACK  // Rasterize it on a worker and draw a scaled STDUI_GLYPH_FALLBACK_SIZE copy meanwhile.
+} SGlyphLoadMode;
+
+typedef enum {
+    STEXT_BITMAP, // Coverage bitmaps rasterized per pixel size, sharpest at small sizes.
+    STEXT_SDF     // Signed distance field, one glyph scales from ~8px to ~200px.
+} STextMode;
+
+// Kerning of printable ASCII pairs is kept in a dense matrix, index 95 stands for every other
+// codepoint (and for "no previous glyph") and always holds 0.
+#define STDUI_KERN_SIZE 96
+
+typedef struct {
+    uint32_t glyphs; // First glyph index << 16 | second glyph index.
+    int advance;     // In font units.
+} SKernPair;
+
+typedef struct {
+    stbtt_fontinfo info;
+    const unsigned char* data;
+    const unsigned char (*bitmap)[8]; // 8x8 glyphs from reserve-font.h instead of TrueType data.
+    int id;
+    int ascent, descent, lineGap; // In font units.
+    STextMode mode;
+    uint64_t fileDevice, fileInode; // Identifies fonts mapped by SLoadFont, 0 otherwise.
+
+    // Kerning read at load time, kern is NULL if the font has none.
+    short* kern;                    // STDUI_KERN_SIZE^2 ASCII pairs in font units.
+    SKernPair* kernPairs;           // Sorted pairs of a 'kern' table, for the other codepoints.
+    int kernPairCount;
+    const unsigned char** gposTables; // GPOS PairPos subtables in lookup order, read in place.
+    int gposTableCount;
+    int asciiGlyphs[95];            // Glyph index of each printable ASCII codepoint.
+} SFont;
+
+// Metrics of a font at one pixel size.
+typedef struct {
+    SFont* font;
+    int pixelSize;
+    float scale;
+    float ascent, descent, lineHeight; // In pixels.
+
+    // Font kerning scaled to this size, see kernAdvance(). Points at a table of zeros
+    // when the font has no kerning, so layout never has to check.
+    const float* kern;
+    float* kernBuffer;
+
+    // Flat lookup for printable ASCII (glyph index + 1, 0 = not looked up yet), so common
+    // text never goes through the hash table. Only valid while asciiGeneration matches the cache.
+    int ascii[95];
+    unsigned int asciiGeneration;
+    STextMode asciiMode;
+} SFontSize;
+
+typedef struct {
+    uint64_t key;        // Font id, pixel size and codepoint, see glyphKey().
+    int page;            // Atlas page, -1 if the glyph has no bitmap (space etc.)
+    int x, y, w, h;      // Rect in the atlas page.
+    float xoff, yoff;    // Offset of the bitmap from the pen position (baseline).
+    float advance;
+    bool pending;        // The rect is reserved but a worker has not delivered the bitmap yet.
+} SGlyph;
+
+typedef struct {
+    int x, y, width;
+} SSkylineNode;
+
+typedef struct {
+    unsigned char* pixels;                         // CPU copy of the page, one byte per texel.
+    SSkylineNode nodes[STDUI_ATLAS_PAGE_SIZE];
+    int nodeCount;
+    int dirtyX0, dirtyY0, dirtyX1, dirtyY1;        // Region that still has to be uploaded.
+    unsigned int lastUsed;                         // Tick of the last draw that used this page.
+    unsigned int generation;                       // Cache generation when the page was added or last evicted.
+} SAtlasPage;
+
+typedef struct {
+    SAtlasPage pages[STDUI_ATLAS_MAX_PAGES];
+    int pageCount;
+
+    // Glyph records, looked up through an open addressing table of (index + 1), 0 is empty.
+    SGlyph* glyphs;
+    int glyphCount, glyphCapacity;
+    int* table;
+    int tableSize;
+
+    unsigned int tick;       // Bumped once per text draw, used for LRU eviction.
+    unsigned int evictions;  // Bumped every time a page is thrown away.
+    unsigned int generation; // Changes whenever glyph indices are invalidated.
+} SGlyphCache;
+
+// Pixel size of text drawn at scale 1.
+#define STDUI_DEFAULT_FONT_SIZE 24.0f
+
+SFont fonts[STDUI_MAX_FONTS];
+int fontCount = 0;
+SFont* currentFont = NULL; // Font used by SDrawText, see SSetFont().
+
+SFontSize fontSizes[STDUI_MAX_FONT_SIZES];
+int fontSizeCount = 0;
+
+// A glyph handed to a worker, the worker only reads the font and writes the staging bitmap.
+typedef struct {
+    uint64_t key;
+    const SFont* font;
+    STextMode mode;
+    float scale;
+    int codepoint;
+    int page, x, y, w, h;    // Where the bitmap goes once it is back on the drawing thread.
+    unsigned char* pixels;   // Staging bitmap, w*h bytes.
+} SGlyphJob;
+
+typedef struct {
+    SGlyphLoadMode mode;
+    int workerCount;
+    int inFlight;            // Jobs submitted and not collected yet, only touched by the drawing thread.
+#ifdef STDUI_GLYPH_THREADS
+    pthread_t workers[STDUI_MAX_GLYPH_WORKERS];
+    pthread_mutex_t lock;
+    pthread_cond_t wake, finished;
+    SGlyphJob queue[STDUI_GLYPH_QUEUE_SIZE]; // Ring buffer of jobs waiting for a worker.
+    int queueHead, queueCount;
+    SGlyphJob done[STDUI_GLYPH_QUEUE_SIZE];  // Rasterized jobs, never more than inFlight.
+    int doneCount;
+    bool quit;
+    void (*wakeLoop)(void* data); // Called by a worker with the lock held once the queue runs dry.
+    void* wakeData;
+#endif
+} SGlyphWorkers;
+
+SGlyphWorkers glyphWorkers;
+
+
+static inline uint64_t glyphKey(const SFontSize* size, STextMode mode, int codepoint) {
+    return ((uint64_t)mode << 56) | ((uint64_t)size->font->id << 48) |
+           ((uint64_t)size->pixelSize << 32) | (uint32_t)codepoint;
+}
+
+// Decode one UTF-8 sequence and advance the pointer past it, never reading at or past end (NULL
+// for NUL-terminated text, the terminator ends any sequence). Malformed or cut off input decodes
+// to U+FFFD and skips a single byte, so the text can always continue.
+static inline int decodeUTF8(const char** text, const char* end) {
+    const unsigned char* s = (const unsigned char*)*text;
+    int c = s[0];
+
+    if (c < 0x80) {
+        *text += 1;
+        return c;
+    }
+
+    int length, min;
+    if ((c & 0xE0) == 0xC0) {
+        length = 2; min = 0x80; c &= 0x1F;
+    } else if ((c & 0xF0) == 0xE0) {
+        length = 3; min = 0x800; c &= 0x0F;
+    } else if ((c & 0xF8) == 0xF0) {
+        length = 4; min = 0x10000; c &= 0x07;
+    } else {
+        *text += 1;
+        return 0xFFFD;
+    }
+
+    for (int i = 1; i < length; i++) {
+        if ((end && *text + i >= end) || (s[i] & 0xC0) != 0x80) {
+            *text += 1;
+            return 0xFFFD;
+        }
+        c = (c << 6) | (s[i] & 0x3F);
+    }
+
+    *text += length;
+    if (c < min || c > 0x10FFFF || (c >= 0xD800 && c <= 0xDFFF)) {
+        return 0xFFFD;
+    }
+    return c;
+}
+
+static inline unsigned int hashGlyphKey(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (unsigned int)key;
+}
+
+static SFont* addFont(void) {
+    if (fontCount >= STDUI_MAX_FONTS) {
+        fprintf(stderr, "ERROR: Too many fonts loaded (max %d)\n", STDUI_MAX_FONTS);
+        return NULL;
+    }
+    SFont* font = &fonts[fontCount];
+    memset(font, 0, sizeof(*font));
+    return font;
+}
+
+static int compareKernPairs(const void* a, const void* b) {
+    uint32_t x = ((const SKernPair*)a)->glyphs, y = ((const SKernPair*)b)->glyphs;
+    return (x > y) - (x < y);
+}
+
+static int findKernPair(const SFont* font, int glyph1, int glyph2) {
+    uint32_t key = ((uint32_t)glyph1 << 16) | (uint32_t)(glyph2 & 0xFFFF);
+    int lo = 0, hi = font->kernPairCount - 1;
+    while (lo <= hi) {
+        int mid = (lo + hi) / 2;
+        if (font->kernPairs[mid].glyphs < key) {
+            lo = mid + 1;
+        } else if (font->kernPairs[mid].glyphs > key) {
+            hi = mid - 1;
+        } else {
+            return font->kernPairs[mid].advance;
+        }
+    }
+    return 0;
+}
+
+static inline int fontU16(const unsigned char* p) { return p[0] << 8 | p[1]; }
+static inline int fontS16(const unsigned char* p) { return (int16_t)(p[0] << 8 | p[1]); }
+
+// Index of a glyph in an OpenType Coverage table, -1 if it is not covered.
+static int fontCoverageIndex(const unsigned char* table, int glyph) {
+    int format = fontU16(table);
+    int lo = 0, hi = fontU16(table + 2) - 1;
+    while ((format == 1 || format == 2) && lo <= hi) {
+        int mid = (lo + hi) / 2;
+        const unsigned char* entry = format == 1 ? table + 4 + 2 * mid : table + 4 + 6 * mid;
+        int first = fontU16(entry), last = format == 1 ? first : fontU16(entry + 2);
+        if (glyph < first) {
+            hi = mid - 1;
+        } else if (glyph > last) {
+            lo = mid + 1;
+        } else {
+            return format == 1 ? mid : fontU16(entry + 4) + glyph - first;
+        }
+    }
+    return -1;
+}
+
+// Class of a glyph in an OpenType ClassDef table, -1 for formats stb_truetype does not read.
+static int fontGlyphClass(const unsigned char* table, int glyph) {
+    if (fontU16(table) == 1) {
+        int first = fontU16(table + 2), count = fontU16(table + 4);
+        return glyph >= first && glyph < first + count ? fontU16(table + 6 + 2 * (glyph - first)) : 0;
+    }
+    if (fontU16(table) == 2) {
+        int lo = 0, hi = fontU16(table + 2) - 1;
+        while (lo <= hi) {
+            int mid = (lo + hi) / 2;
+            const unsigned char* range = table + 4 + 6 * mid;
+            if (glyph < fontU16(range)) {
+                hi = mid - 1;
+            } else if (glyph > fontU16(range + 2)) {
+                lo = mid + 1;
+            } else {
+                return fontU16(range + 4);
+            }
+        }
+        return 0;
+    }
+    return -1;
+}
+
+// GPOS kerning of a glyph pair, read from the PairPos subtables like stbtt_GetGlyphKernAdvance()
+// does: the first subtable that covers glyph1 and has the pair decides, a class subtable
+// decides every pair of the glyphs it covers.
+static int findGposPair(const SFont* font, int glyph1, int glyph2) {
+    for (int t = 0; t < font->gposTableCount; t++) {
+        const unsigned char* table = font->gposTables[t];
+        int coverage = fontCoverageIndex(table + fontU16(table + 2), glyph1);
+        if (coverage < 0) {
+            continue;
+        }
+        int format = fontU16(table);
+        if ((format != 1 && format != 2) || fontU16(table + 4) != 4 || fontU16(table + 6) != 0) {
+            return 0; // Only XAdvance of the first glyph, like stb_truetype.
+        }
+
+        if (format == 1) {
+            if (coverage >= fontU16(table + 8)) {
+                return 0;
+            }
+            const unsigned char* set = table + fontU16(table + 10 + 2 * coverage);
+            int lo = 0, hi = fontU16(set) - 1;
+            while (lo <= hi) {
+                int mid = (lo + hi) / 2;
+                int second = fontU16(set + 2 + 4 * mid);
+                if (glyph2 < second) {
+                    hi = mid - 1;
+                } else if (glyph2 > second) {
+                    lo = mid + 1;
+                } else {
+                    return fontS16(set + 4 + 4 * mid);
+                }
+            }
+            continue;
+        }
+
+        int class1 = fontGlyphClass(table + fontU16(table + 8), glyph1);
+        int class2 = fontGlyphClass(table + fontU16(table + 10), glyph2);
+        int class1Count = fontU16(table + 12), class2Count = fontU16(table + 14);
+        if (class1 < 0 || class1 >= class1Count || class2 < 0 || class2 >= class2Count) {
+            return 0;
+        }
+        return fontS16(table + 16 + 2 * (class1 * class2Count + class2));
+    }
+    return 0;
+}
+
+// Kerning of two glyph indices in font units, from GPOS when the font has it.
+static int fontKernPair(const SFont* font, int glyph1, int glyph2) {
+    return font->info.gpos ? findGposPair(font, glyph1, glyph2) : findKernPair(font, glyph1, glyph2);
+}
+
+// Collect the GPOS pair adjustment subtables, the pairs stay in the font data.
+static bool loadGposKerning(SFont* font) {
+    const stbtt_fontinfo* info = &font->info;
+    const unsigned char* gpos = info->data + info->gpos;
+    if (fontU16(gpos) != 1 || fontU16(gpos + 2) != 0) {
+        return true;
+    }
+
+    // Subtables of pair adjustment lookups, counted first and then listed.
+    const unsigned char* lookups = gpos + fontU16(gpos + 8);
+    int lookupCount = fontU16(lookups), count = 0;
+    for (int l = 0; l < lookupCount; l++) {
+        const unsigned char* lookup = lookups + fontU16(lookups + 2 + 2 * l);
+        count += fontU16(lookup) == 2 ? fontU16(lookup + 4) : 0;
+    }
+    if (count == 0) {
+        return true;
+    }
+    font->gposTables = (const unsigned char**)malloc(count * sizeof(*font->gposTables));
+    if (!font->gposTables) {
+        return false;
+    }
+    for (int l = 0; l < lookupCount; l++) {
+        const unsigned char* lookup = lookups + fontU16(lookups + 2 + 2 * l);
+        for (int t = 0, subTableCount = fontU16(lookup) == 2 ? fontU16(lookup + 4) : 0; t < subTableCount; t++) {
+            font->gposTables[font->gposTableCount++] = lookup + fontU16(lookup + 6 + 2 * t);
+        }
+    }
+    return true;
+}
+
+// Read the font's kerning once: the ASCII pairs into a dense table, the rest is looked up per
+// pair. Like stb_truetype a font with a GPOS table is kerned by GPOS only.
+static void loadKerning(SFont* font) {
+    const stbtt_fontinfo* info = &font->info;
+    int length = stbtt_GetKerningTableLength(info);
+    if (length <= 0 && !info->gpos) {
+        return;
+    }
+
+    if (info->gpos) {
+        if (!loadGposKerning(font)) {
+            fprintf(stderr, "ERROR: Failed to allocate GPOS kerning tables\n");
+            return;
+        }
+    } else {
+        stbtt_kerningentry* entries = (stbtt_kerningentry*)malloc(length * sizeof(stbtt_kerningentry));
+        font->kernPairs = (SKernPair*)malloc(length * sizeof(SKernPair));
+        if (!entries || !font->kernPairs) {
+            fprintf(stderr, "ERROR: Failed to allocate kerning pairs\n");
+            free(entries);
+            free(font->kernPairs);
+            font->kernPairs = NULL;
+            return;
+        }
+        length = stbtt_GetKerningTable(info, entries, length);
+        for (int i = 0; i < length; i++) {
+            font->kernPairs[i].glyphs = ((uint32_t)entries[i].glyph1 << 16) | (uint32_t)(entries[i].glyph2 & 0xFFFF);
+            font->kernPairs[i].advance = entries[i].advance;
+        }
+        font->kernPairCount = length;
+        qsort(font->kernPairs, length, sizeof(SKernPair), compareKernPairs);
+        free(entries);
+    }
+
+    font->kern = (short*)calloc(STDUI_KERN_SIZE * STDUI_KERN_SIZE, sizeof(short));
+    if (!font->kern) {
+        fprintf(stderr, "ERROR: Failed to allocate kerning table\n");
+        return;
+    }
+    for (int a = 0; a < 95; a++) {
+        for (int b = 0; b < 95; b++) {
+            font->kern[a * STDUI_KERN_SIZE + b] = (short)fontKernPair(font, font->asciiGlyphs[a], font->asciiGlyphs[b]);
+        }
+    }
+}
+
+// Load a TrueType font from memory, the data must stay valid for the lifetime of the program.
+SFont* SLoadFontMemory(const unsigned char* data) {
+    SFont* font = addFont();
+    if (!font) {
+        return NULL;
+    }
+
+    if (!stbtt_InitFont(&font->info, data, stbtt_GetFontOffsetForIndex(data, 0))) {
+        fprintf(stderr, "ERROR: Failed to parse font data\n");
+        return NULL;
+    }
+
+    font->data = data;
+    font->id = fontCount++;
+    font->mode = STEXT_BITMAP;
+    stbtt_GetFontVMetrics(&font->info, &font->ascent, &font->descent, &font->lineGap);
+    for (int i = 0; i < 95; i++) {
+        font->asciiGlyphs[i] = stbtt_FindGlyphIndex(&font->info, 32 + i);
+    }
+    loadKerning(font);
+    return font;
+}
+
+// Load a TrueType font file. The file is mapped read only, loading the same file again
+// returns the font that is already loaded, so every window and size shares one copy.
+SFont* SLoadFont(const char* fontPath) {
+#if defined(__unix__) || defined(__APPLE__)
+    int fd = open(fontPath, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "ERROR: Failed to open font file: %s\n", fontPath);
+        return NULL;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0 || fileInfo.st_size <= 0) {
+        fprintf(stderr, "ERROR: Failed to read font file: %s\n", fontPath);
+        close(fd);
+        return NULL;
+    }
+
+    for (int i = 0; i < fontCount; i++) {
+        if (fonts[i].fileInode == (uint64_t)fileInfo.st_ino && fonts[i].fileDevice == (uint64_t)fileInfo.st_dev) {
+            close(fd);
+            return &fonts[i];
+        }
+    }
+
+    void* data = mmap(NULL, fileInfo.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd); // The mapping keeps the file open.
+    if (data == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Failed to map font file: %s\n", fontPath);
+        return NULL;
+    }
+
+    SFont* font = SLoadFontMemory((const unsigned char*)data);
+    if (!font) {
+        munmap(data, fileInfo.st_size);
+        return NULL;
+    }
+    font->fileDevice = (uint64_t)fileInfo.st_dev;
+    font->fileInode = (uint64_t)fileInfo.st_ino;
+    return font;
+#else
+    FILE* fontFile = fopen(fontPath, "rb");
+    if (!fontFile) {
+        fprintf(stderr, "ERROR: Failed to open font file: %s\n", fontPath);
+        return NULL;
+    }
+
+    fseek(fontFile, 0, SEEK_END);
+    long fileSize = ftell(fontFile);
+    fseek(fontFile, 0, SEEK_SET);
+
+    unsigned char* data = (unsigned char*)malloc(fileSize);
+    if (!data) {
+        fprintf(stderr, "ERROR: Failed to allocate memory for font file\n");
+        fclose(fontFile);
+        return NULL;
+    }
+
+    if (fread(data, 1, fileSize, fontFile) != (size_t)fileSize) {
+        fprintf(stderr, "ERROR: Failed to read font file: %s\n", fontPath);
+        fclose(fontFile);
+        free(data);
+        return NULL;
+    }
+    fclose(fontFile);
+
+    SFont* font = SLoadFontMemory(data);
+    if (!font) {
+        free(data);
+    }
+    return font;
+#endif
+}
+
+// The 8x8 font from reserve-font.h, rows top to bottom, the bottom row is below the baseline.
+static SFont* loadReserveFont(void) {
+    SFont* font = addFont();
+    if (!font) {
+        return NULL;
+    }
+
+    font->bitmap = fontData;
+    font->id = fontCount++;
+    font->mode = STEXT_BITMAP;
+    font->ascent = 7;
+    font->descent = -1;
+    font->lineGap = 1;
+    return font;
+}
+
+// The font used when no font file is given: the built in Courier New, or the 8x8 reserve font
+// when it is compiled out (STDUI_NO_EMBEDDED_FONT). Loaded once and shared by every window.
+SFont* SLoadDefaultFont() {
+    static SFont* defaultFont = NULL;
+    if (defaultFont) {
+        return defaultFont;
+    }
+
+#ifndef STDUI_NO_EMBEDDED_FONT
+    defaultFont = SLoadFontMemory(courier_new_ttf);
+#endif
+    if (!defaultFont) {
+        defaultFont = loadReserveFont();
+    }
+    return defaultFont;
+}
+
+// Font unit queries that also cover the reserve font.
+
+static inline bool fontHasGlyph(const SFont* font, int codepoint) {
+    if (font->bitmap) {
+        return codepoint >= 32 && codepoint <= 'z';
+    }
+    return stbtt_FindGlyphIndex(&font->info, codepoint) != 0;
+}
+
+static inline float fontScaleForPixelHeight(const SFont* font, float pixelSize) {
+    if (font->bitmap) {
+        return pixelSize / (font->ascent - font->descent);
+    }
+    return stbtt_ScaleForPixelHeight(&font->info, pixelSize);
+}
+
+// Glyph index of a codepoint, printable ASCII without a cmap lookup. 0 for bitmap fonts.
+static inline int fontGlyphIndex(const SFont* font, int codepoint) {
+    if (font->bitmap) {
+        return 0;
+    }
+    unsigned int ascii = (unsigned int)codepoint - 32u;
+    return ascii < 95u ? font->asciiGlyphs[ascii] : stbtt_FindGlyphIndex(&font->info, codepoint);
+}
+
+// Advance of a glyph from fontGlyphIndex() in font units.
+static inline int fontGlyphAdvance(const SFont* font, int glyph) {
+    if (font->bitmap) {
+        return 8;
+    }
+    int advance, lsb;
+    stbtt_GetGlyphHMetrics(&font->info, glyph, &advance, &lsb);
+    return advance;
+}
+
+static inline int fontAdvance(const SFont* font, int codepoint) {
+    if (font->bitmap) {
+        return 8;
+    }
+    int advance, lsb;
+    stbtt_GetCodepointHMetrics(&font->info, codepoint, &advance, &lsb);
+    return advance;
+}
+
+// Select how a font's glyphs are rasterized, glyphs of the other mode stay cached.
+void SSetFontMode(SFont* font, STextMode mode) {
+    if (font) {
+        font->mode = mode;
+    }
+}
+
+// Get the metrics of a font at a pixel size, sizes are rounded to whole pixels.
+SFontSize* getFontSize(SFont* font, float pixelSize) {
+    int px = (int)(pixelSize + 0.5f);
+    if (px < 1) px = 1;
+    if (px > 0xFFFF) px = 0xFFFF;
+
+    for (int i = 0; i < fontSizeCount; i++) {
+        if (fontSizes[i].font == font && fontSizes[i].pixelSize == px) {
+            return &fontSizes[i];
+        }
+    }
+
+    // Recycle the oldest entry when full, glyphs stay cached since they are keyed by value.
+    static int nextSlot = 0;
+    SFontSize* size;
+    if (fontSizeCount < STDUI_MAX_FONT_SIZES) {
+        size = &fontSizes[fontSizeCount++];
+    } else {
+        size = &fontSizes[nextSlot];
+        nextSlot = (nextSlot + 1) % STDUI_MAX_FONT_SIZES;
+    }
+
+    size->font = font;
+    size->pixelSize = px;
+    size->scale = fontScaleForPixelHeight(font, (float)px);
+    size->ascent = font->ascent * size->scale;
+    size->descent = font->descent * size->scale;
+    size->lineHeight = (font->ascent - font->descent + font->lineGap) * size->scale;
+    size->asciiGeneration = 0; // Never a valid cache generation.
+
+    static const float noKerning[STDUI_KERN_SIZE * STDUI_KERN_SIZE];
+    size->kern = noKerning;
+    if (font->kern) {
+        if (!size->kernBuffer) {
+            size->kernBuffer = (float*)malloc(STDUI_KERN_SIZE * STDUI_KERN_SIZE * sizeof(float));
+        }
+        if (size->kernBuffer) {
+            for (int i = 0; i < STDUI_KERN_SIZE * STDUI_KERN_SIZE; i++) {
+                size->kernBuffer[i] = font->kern[i] * size->scale;
+            }
+            size->kern = size->kernBuffer;
+        }
+    }
+    return size;
+}
+
+// Pixels to add between two codepoints, first is 0 at the start of a line or word. glyph1 and
+// glyph2 are their fontGlyphIndex(), resolved once per character by the caller. Printable
+// ASCII pairs are a single table load with no branches on the font or the pair.
+static inline float kernAdvance(const SFontSize* size, int first, int second, int glyph1, int glyph2) {
+    if ((first > 126 || second > 126) && first && size->font->kern) {
+        return fontKernPair(size->font, glyph1, glyph2) * size->scale;
+    }
+    unsigned int a = (unsigned int)first - 32u, b = (unsigned int)second - 32u;
+    a = a < 95u ? a : 95u;
+    b = b < 95u ? b : 95u;
+    return size->kern[a * STDUI_KERN_SIZE + b];
+}
+
+
+// Skyline packing (bottom-left heuristic).
+static void skylineReset(SAtlasPage* page) {
+    page->nodeCount = 1;
+    page->nodes[0].x = 0;
+    page->nodes[0].y = 0;
+    page->nodes[0].width = STDUI_ATLAS_PAGE_SIZE;
+}
+
+// Returns the y a rect of width w would rest at when placed on node i, or -1 if it does not fit.
+static int skylineFit(const SAtlasPage* page, int i, int w, int h) {
+    int x = page->nodes[i].x;
+    if (x + w > STDUI_ATLAS_PAGE_SIZE) {
+        return -1;
+    }
+
+    int y = 0;
+    int remaining = w;
+    while (remaining > 0) {
+        if (i >= page->nodeCount) {
+            return -1;
+        }
+        if (page->nodes[i].y > y) {
+            y = page->nodes[i].y;
+        }
+        if (y + h > STDUI_ATLAS_PAGE_SIZE) {
+            return -1;
+        }
+        remaining -= page->nodes[i].width;
+        i++;
+    }
+    return y;
+}
+
+static bool skylineInsert(SAtlasPage* page, int w, int h, int* outX, int* outY) {
+    int best = -1, bestY = STDUI_ATLAS_PAGE_SIZE, bestWidth = STDUI_ATLAS_PAGE_SIZE;
+
+    for (int i = 0; i < page->nodeCount; i++) {
+        int y = skylineFit(page, i, w, h);
+        if (y >= 0 && (y + h < bestY || (y + h == bestY && page->nodes[i].width < bestWidth))) {
+            best = i;
+            bestY = y + h;
+            bestWidth = page->nodes[i].width;
+        }
+    }
+
+    if (best < 0 || page->nodeCount >= STDUI_ATLAS_PAGE_SIZE) {
+        return false;
+    }
+
+    int x = page->nodes[best].x;
+    int y = bestY - h;
+
+    // Insert the new node and shrink/remove the ones it covers.
+    memmove(&page->nodes[best + 1], &page->nodes[best], (page->nodeCount - best) * sizeof(SSkylineNode));
+    page->nodes[best].x = x;
+    page->nodes[best].y = bestY;
+    page->nodes[best].width = w;
+    page->nodeCount++;
+
+    for (int i = best + 1; i < page->nodeCount; i++) {
+        SSkylineNode* prev = &page->nodes[i - 1];
+        SSkylineNode* node = &page->nodes[i];
+        if (node->x >= prev->x + prev->width) {
+            break;
+        }
+        int shrink = prev->x + prev->width - node->x;
+        node->x += shrink;
+        node->width -= shrink;
+        if (node->width > 0) {
+            break;
+        }
+        memmove(&page->nodes[i], &page->nodes[i + 1], (page->nodeCount - i - 1) * sizeof(SSkylineNode));
+        page->nodeCount--;
+        i--;
+    }
+
+    // Merge neighbours at the same height.
+    for (int i = 0; i < page->nodeCount - 1; i++) {
+        if (page->nodes[i].y == page->nodes[i + 1].y) {
+            page->nodes[i].width += page->nodes[i + 1].width;
+            memmove(&page->nodes[i + 1], &page->nodes[i + 2], (page->nodeCount - i - 2) * sizeof(SSkylineNode));
+            page->nodeCount--;
+            i--;
+        }
+    }
+
+    *outX = x;
+    *outY = y;
+    return true;
+}
+
+static void markPageDirty(SAtlasPage* page, int x0, int y0, int x1, int y1) {
+    if (page->dirtyX1 <= page->dirtyX0) {
+        page->dirtyX0 = x0; page->dirtyY0 = y0;
+        page->dirtyX1 = x1; page->dirtyY1 = y1;
+        return;
+    }
+    if (x0 < page->dirtyX0) page->dirtyX0 = x0;
+    if (y0 < page->dirtyY0) page->dirtyY0 = y0;
+    if (x1 > page->dirtyX1) page->dirtyX1 = x1;
+    if (y1 > page->dirtyY1) page->dirtyY1 = y1;
+}
+
+
+// Glyph table.
+static void glyphTableInsert(SGlyphCache* cache, int index) {
+    unsigned int mask = cache->tableSize - 1;
+    unsigned int slot = hashGlyphKey(cache->glyphs[index].key) & mask;
+    while (cache->table[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    cache->table[slot] = index + 1;
+}
+
+static void glyphTableRebuild(SGlyphCache* cache, int tableSize) {
+    free(cache->table);
+    cache->tableSize = tableSize;
+    cache->table = (int*)calloc(tableSize, sizeof(int));
+    for (int i = 0; i < cache->glyphCount; i++) {
+        glyphTableInsert(cache, i);
+    }
+}
+
+static SGlyph* glyphTableFind(SGlyphCache* cache, uint64_t key) {
+    unsigned int mask = cache->tableSize - 1;
+    unsigned int slot = hashGlyphKey(key) & mask;
+    while (cache->table[slot] != 0) {
+        SGlyph* glyph = &cache->glyphs[cache->table[slot] - 1];
+        if (glyph->key == key) {
+            return glyph;
+        }
+        slot = (slot + 1) & mask;
+    }
+    return NULL;
+}
+
+static unsigned int nextGlyphGeneration(void) {
+    static unsigned int generation = 0;
+    return ++generation;
+}
+
+bool initGlyphCache(SGlyphCache* cache) {
+    memset(cache, 0, sizeof(*cache));
+    cache->generation = nextGlyphGeneration();
+    cache->glyphCapacity = 256;
+    cache->glyphs = (SGlyph*)malloc(cache->glyphCapacity * sizeof(SGlyph));
+    cache->tableSize = 512;
+    cache->table = (int*)calloc(cache->tableSize, sizeof(int));
+    if (!cache->glyphs || !cache->table) {
+        fprintf(stderr, "ERROR: Failed to allocate glyph cache\n");
+        return false;
+    }
+    return true;
+}
+
+static void collectGlyphJobs(SGlyphCache* cache, bool wait);
+
+void destroyGlyphCache(SGlyphCache* cache) {
+    collectGlyphJobs(NULL, true); // Finished jobs would land in the next cache otherwise.
+    for (int i = 0; i < cache->pageCount; i++) {
+        free(cache->pages[i].pixels);
+    }
+    free(cache->glyphs);
+    free(cache->table);
+    memset(cache, 0, sizeof(*cache));
+}
+
+static bool addAtlasPage(SGlyphCache* cache) {
+    if (cache->pageCount >= STDUI_ATLAS_MAX_PAGES) {
+        return false;
+    }
+    SAtlasPage* page = &cache->pages[cache->pageCount];
+    page->pixels = (unsigned char*)calloc(STDUI_ATLAS_PAGE_SIZE * STDUI_ATLAS_PAGE_SIZE, 1);
+    if (!page->pixels) {
+        return false;
+    }
+    skylineReset(page);
+    page->dirtyX0 = page->dirtyY0 = page->dirtyX1 = page->dirtyY1 = 0;
+    page->lastUsed = cache->tick;
+    page->generation = cache->generation;
+    cache->pageCount++;
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Added glyph atlas page %d.\n", cache->pageCount - 1);
+    #endif
+    return true;
+}
+
+// Throw away every glyph on a page so it can be packed again.
+static void evictAtlasPage(SGlyphCache* cache, int pageIndex) {
+    SAtlasPage* page = &cache->pages[pageIndex];
+    memset(page->pixels, 0, STDUI_ATLAS_PAGE_SIZE * STDUI_ATLAS_PAGE_SIZE);
+    skylineReset(page);
+    markPageDirty(page, 0, 0, STDUI_ATLAS_PAGE_SIZE, STDUI_ATLAS_PAGE_SIZE);
+
+    int kept = 0;
+    for (int i = 0; i < cache->glyphCount; i++) {
+        if (cache->glyphs[i].page != pageIndex) {
+            cache->glyphs[kept++] = cache->glyphs[i];
+        }
+    }
+    cache->glyphCount = kept;
+    glyphTableRebuild(cache, cache->tableSize);
+    cache->evictions++;
+    cache->generation = nextGlyphGeneration();
+    page->generation = cache->generation;
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Evicted glyph atlas page %d.\n", pageIndex);
+    #endif
+}
+
+// Find room for a w*h rect: existing pages first, then a new page, then the least recently used page.
+static int allocateAtlasRect(SGlyphCache* cache, int w, int h, int* x, int* y) {
+    if (w > STDUI_ATLAS_PAGE_SIZE || h > STDUI_ATLAS_PAGE_SIZE) {
+        return -1;
+    }
+
+    for (int i = cache->pageCount - 1; i >= 0; i--) {
+        if (skylineInsert(&cache->pages[i], w, h, x, y)) {
+            return i;
+        }
+    }
+
+    if (addAtlasPage(cache) && skylineInsert(&cache->pages[cache->pageCount - 1], w, h, x, y)) {
+        return cache->pageCount - 1;
+    }
+
+    // Never evict a page that the current draw already references.
+    int coldest = -1;
+    for (int i = 0; i < cache->pageCount; i++) {
+        if (cache->pages[i].lastUsed != cache->tick &&
+            (coldest < 0 || cache->pages[i].lastUsed < cache->pages[coldest].lastUsed)) {
+            coldest = i;
+        }
+    }
+    if (coldest < 0) {
+        return -1;
+    }
+
+    evictAtlasPage(cache, coldest);
+    if (skylineInsert(&cache->pages[coldest], w, h, x, y)) {
+        return coldest;
+    }
+    return -1;
+}
+
+static SGlyph* addGlyph(SGlyphCache* cache, const SGlyph* glyph) {
+    if (cache->glyphCount >= cache->glyphCapacity) {
+        int capacity = cache->glyphCapacity * 2;
+        SGlyph* glyphs = (SGlyph*)realloc(cache->glyphs, capacity * sizeof(SGlyph));
+        if (!glyphs) {
+            fprintf(stderr, "ERROR: Failed to grow glyph cache\n");
+            return NULL;
+        }
+        cache->glyphs = glyphs;
+        cache->glyphCapacity = capacity;
+    }
+
+    cache->glyphs[cache->glyphCount] = *glyph;
+    cache->glyphCount++;
+
+    // Keep the load factor under 1/2.
+    if (cache->glyphCount * 2 > cache->tableSize) {
+        glyphTableRebuild(cache, cache->tableSize * 2);
+    } else {
+        glyphTableInsert(cache, cache->glyphCount - 1);
+    }
+    return &cache->glyphs[cache->glyphCount - 1];
+}
+
+// Size of the bitmap a glyph needs and its offset from the pen position, w/h are 0 for blank glyphs.
+static void measureGlyph(const SFontSize* size, STextMode mode, int codepoint, SGlyph* glyph, int* w, int* h) {
+    const SFont* font = size->font;
+    glyph->advance = fontAdvance(font, codepoint) * size->scale;
+
+    int x0, y0, x1, y1;
+    if (font->bitmap) {
+        // Reserve font glyphs fill their whole cell, scaled with nearest neighbour sampling.
+        x0 = 0;
+        y0 = -(int)(font->ascent * size->scale + 0.5f);
+        x1 = (int)(8 * size->scale + 0.5f);
+        y1 = y0 + x1;
+    } else {
+        stbtt_GetCodepointBitmapBoxSubpixel(&font->info, codepoint, size->scale, size->scale, 0.0f, 0.0f, &x0, &y0, &x1, &y1);
+    }
+    if (x1 <= x0 || y1 <= y0) {
+        glyph->xoff = glyph->yoff = 0.0f;
+        *w = *h = 0;
+        return;
+    }
+
+    // Distance fields extend STDUI_SDF_PADDING pixels past the outline, see stbtt_GetGlyphSDF.
+    int padding = mode == STEXT_SDF ? STDUI_SDF_PADDING : 0;
+    glyph->xoff = (float)(x0 - padding);
+    glyph->yoff = (float)(y0 - padding);
+    *w = x1 - x0 + 2 * padding;
+    *h = y1 - y0 + 2 * padding;
+}
+
+// Rasterize a measured glyph into dst. Only reads the font, so workers can call it too.
+static void renderGlyph(const SFont* font, STextMode mode, float scale, int codepoint,
+                        unsigned char* dst, int w, int h, int stride) {
+    const stbtt_fontinfo* info = &font->info;
+
+    if (font->bitmap) {
+        // Distance fields of the reserve font are just its coverage, the padding stays empty.
+        int padding = mode == STEXT_SDF ? STDUI_SDF_PADDING : 0;
+        const unsigned char* rows = font->bitmap[fontHasGlyph(font, codepoint) ? codepoint - 32 : '?' - 32];
+        int cell = w - 2 * padding;
+        for (int y = 0; y < cell; y++) {
+            unsigned char bits = rows[y * 8 / cell];
+            unsigned char* row = dst + (y + padding) * stride + padding;
+            for (int x = 0; x < cell; x++) {
+                row[x] = (bits & (0x80 >> (x * 8 / cell))) ? 255 : 0;
+            }
+        }
+    } else if (mode == STEXT_SDF) {
+        // Distance 0 maps to STDUI_SDF_ONEDGE, the padding covers the rest of the byte range.
+        int sw = 0, sh = 0, xoff, yoff;
+        unsigned char* sdf = stbtt_GetCodepointSDF(info, scale, codepoint, STDUI_SDF_PADDING, STDUI_SDF_ONEDGE,
+                                                   (float)STDUI_SDF_ONEDGE / STDUI_SDF_PADDING, &sw, &sh, &xoff, &yoff);
+        if (!sdf) {
+            return;
+        }
+        for (int row = 0; row < h && row < sh; row++) {
+            memcpy(dst + row * stride, sdf + row * sw, w < sw ? w : sw);
+        }
+        stbtt_FreeSDF(sdf, NULL);
+    } else {
+        stbtt_MakeCodepointBitmap(info, dst, w, h, stride, scale, scale, codepoint);
+    }
+}
+
+
+// Worker pool
+
+#ifdef STDUI_GLYPH_THREADS
+static void* glyphWorkerMain(void* arg) {
+    SGlyphWorkers* workers = (SGlyphWorkers*)arg;
+
+    pthread_mutex_lock(&workers->lock);
+    for (;;) {
+        while (!workers->quit && workers->queueCount == 0) {
+            pthread_cond_wait(&workers->wake, &workers->lock);
+        }
+        if (workers->quit) {
+            break;
+        }
+
+        SGlyphJob job = workers->queue[workers->queueHead];
+        workers->queueHead = (workers->queueHead + 1) % STDUI_GLYPH_QUEUE_SIZE;
+        workers->queueCount--;
+        pthread_mutex_unlock(&workers->lock);
+
+        job.pixels = (unsigned char*)calloc(job.w * job.h, 1);
+        if (job.pixels) {
+            renderGlyph(job.font, job.mode, job.scale, job.codepoint, job.pixels, job.w, job.h, job.w);
+        }
+
+        pthread_mutex_lock(&workers->lock);
+        workers->done[workers->doneCount++] = job;
+        pthread_cond_signal(&workers->finished);
+        // An idle loop would not draw the batch until the next input.
+        if (workers->queueCount == 0 && workers->wakeLoop) {
+            workers->wakeLoop(workers->wakeData);
+        }
+    }
+    pthread_mutex_unlock(&workers->lock);
+    return NULL;
+}
+#endif
+
+// Set what the workers call to wake the event loop once their queue is done, NULL for nothing.
+static void setGlyphWake(void (*wakeLoop)(void* data), void* data) {
+#ifdef STDUI_GLYPH_THREADS
+    SGlyphWorkers* workers = &glyphWorkers;
+    if (workers->workerCount > 0) {
+        pthread_mutex_lock(&workers->lock);
+    }
+    workers->wakeLoop = wakeLoop;
+    workers->wakeData = data;
+    if (workers->workerCount > 0) {
+        pthread_mutex_unlock(&workers->lock);
+    }
+#else
+    (void)wakeLoop;
+    (void)data;
+#endif
+}
+
+// Hand a glyph to the workers, false if it has to be rasterized right away instead.
+static bool submitGlyphJob(const SGlyphJob* job) {
+#ifdef STDUI_GLYPH_THREADS
+    SGlyphWorkers* workers = &glyphWorkers;
+    if (workers->workerCount == 0 || workers->inFlight >= STDUI_GLYPH_QUEUE_SIZE) {
+        return false;
+    }
+
+    pthread_mutex_lock(&workers->lock);
+    workers->queue[(workers->queueHead + workers->queueCount) % STDUI_GLYPH_QUEUE_SIZE] = *job;
+    workers->queueCount++;
+    pthread_cond_signal(&workers->wake);
+    pthread_mutex_unlock(&workers->lock);
+
+    workers->inFlight++;
+    return true;
+#else
+    (void)job;
+    return false;
+#endif
+}
+
+// Copy finished glyphs into their atlas pages, they are uploaded with the next draw.
+// Jobs whose glyph was evicted meanwhile are dropped. A NULL cache drops everything.
+static void collectGlyphJobs(SGlyphCache* cache, bool wait) {
+#ifdef STDUI_GLYPH_THREADS
+    SGlyphWorkers* workers = &glyphWorkers;
+    if (workers->inFlight == 0) {
+        return;
+    }
+
+    static SGlyphJob done[STDUI_GLYPH_QUEUE_SIZE];
+    int doneCount;
+
+    pthread_mutex_lock(&workers->lock);
+    while (wait && workers->doneCount < workers->inFlight) {
+        pthread_cond_wait(&workers->finished, &workers->lock);
+    }
+    doneCount = workers->doneCount;
+    memcpy(done, workers->done, doneCount * sizeof(SGlyphJob));
+    workers->doneCount = 0;
+    pthread_mutex_unlock(&workers->lock);
+
+    workers->inFlight -= doneCount;
+    for (int i = 0; i < doneCount; i++) {
+        SGlyphJob* job = &done[i];
+        SGlyph* glyph = cache ? glyphTableFind(cache, job->key) : NULL;
+        if (glyph && glyph->pending && glyph->page == job->page && glyph->x == job->x && glyph->y == job->y) {
+            SAtlasPage* page = &cache->pages[job->page];
+            if (job->pixels) {
+                for (int row = 0; row < job->h; row++) {
+                    memcpy(page->pixels + (job->y + row) * STDUI_ATLAS_PAGE_SIZE + job->x,
+                           job->pixels + row * job->w, job->w);
+                }
+                markPageDirty(page, job->x, job->y, job->x + job->w, job->y + job->h);
+            }
+            glyph->pending = false;
+        }
+        free(job->pixels);
+    }
+#else
+    (void)cache;
+    (void)wait;
+#endif
+}
+
+// Wait for the queued glyphs and stop the threads, pending glyphs are finished into cache.
+static void stopGlyphWorkers(SGlyphCache* cache) {
+    glyphWorkers.mode = SGLYPH_LOAD_BLOCK;
+#ifdef STDUI_GLYPH_THREADS
+    SGlyphWorkers* workers = &glyphWorkers;
+    if (workers->workerCount == 0) {
+        return;
+    }
+
+    collectGlyphJobs(cache, true);
+
+    pthread_mutex_lock(&workers->lock);
+    workers->quit = true;
+    pthread_cond_broadcast(&workers->wake);
+    pthread_mutex_unlock(&workers->lock);
+    for (int i = 0; i < workers->workerCount; i++) {
+        pthread_join(workers->workers[i], NULL);
+    }
+
+    pthread_mutex_destroy(&workers->lock);
+    pthread_cond_destroy(&workers->wake);
+    pthread_cond_destroy(&workers->finished);
+    workers->workerCount = 0;
+    workers->quit = false;
+#else
+    (void)cache;
+#endif
+}
+
+// Start workerCount threads (<= 0 picks one per spare core), the workers must be stopped.
+static bool startGlyphWorkers(SGlyphLoadMode mode, int workerCount) {
+    SGlyphWorkers* workers = &glyphWorkers;
+
+#ifdef STDUI_GLYPH_THREADS
+    if (workerCount <= 0) {
+        workerCount = (int)sysconf(_SC_NPROCESSORS_ONLN) - 1;
+    }
+    if (workerCount < 1) workerCount = 1;
+    if (workerCount > STDUI_MAX_GLYPH_WORKERS) workerCount = STDUI_MAX_GLYPH_WORKERS;
+
+    pthread_mutex_init(&workers->lock, NULL);
+    pthread_cond_init(&workers->wake, NULL);
+    pthread_cond_init(&workers->finished, NULL);
+    workers->queueHead = workers->queueCount = workers->doneCount = 0;
+    workers->quit = false;
+
+    for (int i = 0; i < workerCount; i++) {
+        if (pthread_create(&workers->workers[i], NULL, glyphWorkerMain, workers) != 0) {
+            fprintf(stderr, "ERROR: Failed to start glyph worker thread\n");
+            break;
+        }
+        workers->workerCount++;
+    }
+    if (workers->workerCount == 0) {
+        return false;
+    }
+
+    workers->mode = mode;
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Started %d glyph worker threads.\n", workers->workerCount);
+    #endif
+    return true;
+#else
+    (void)mode;
+    (void)workerCount;
+    fprintf(stderr, "ERROR: Glyph worker threads are not supported on this platform\n");
+    return false;
+#endif
+}
+
+// Number of glyphs still being rasterized. The workers wake the window that last drew text
+// when they are done, other windows waiting in SWaitEvents() need a finite timeout meanwhile.
+int SGetPendingGlyphCount() {
+    return glyphWorkers.inFlight;
+}
+
+// Reserve atlas space for a glyph and rasterize it, or queue it for a worker when allowed.
+static SGlyph* rasterizeGlyph(SGlyphCache* cache, SFontSize* size, STextMode mode, int codepoint, bool async) {
+    SGlyph glyph;
+    glyph.key = glyphKey(size, mode, codepoint);
+    glyph.page = -1;
+    glyph.x = glyph.y = glyph.w = glyph.h = 0;
+    glyph.pending = false;
+
+    int w, h;
+    measureGlyph(size, mode, codepoint, &glyph, &w, &h);
+
+    if (w > 0 && h > 0) {
+        int x, y;
+        int page = allocateAtlasRect(cache, w + STDUI_GLYPH_PADDING, h + STDUI_GLYPH_PADDING, &x, &y);
+        if (page < 0) {
+            fprintf(stderr, "ERROR: Glyph atlas is full\n");
+            return NULL;
+        }
+
+        SGlyphJob job = { glyph.key, size->font, mode, size->scale, codepoint, page, x, y, w, h, NULL };
+        if (async && submitGlyphJob(&job)) {
+            glyph.pending = true;
+        } else {
+            SAtlasPage* atlas = &cache->pages[page];
+            renderGlyph(size->font, mode, size->scale, codepoint,
+                        atlas->pixels + y * STDUI_ATLAS_PAGE_SIZE + x, w, h, STDUI_ATLAS_PAGE_SIZE);
+            markPageDirty(atlas, x, y, x + w, y + h);
+        }
+
+        glyph.page = page;
+        glyph.x = x;
+        glyph.y = y;
+        glyph.w = w;
+        glyph.h = h;
+    }
+
+    return addGlyph(cache, &glyph);
+}
+
+static SGlyph* findOrRasterizeGlyph(SGlyphCache* cache, SFontSize* size, STextMode mode, int codepoint) {
+    SGlyph* glyph = glyphTableFind(cache, glyphKey(size, mode, codepoint));
+    if (!glyph) {
+        bool async = glyphWorkers.mode != SGLYPH_LOAD_BLOCK && size->pixelSize > STDUI_GLYPH_FALLBACK_SIZE;
+        glyph = rasterizeGlyph(cache, size, mode, codepoint, async);
+    }
+    return glyph;
+}
+
+// Look up a glyph to draw in mode (usually the font's mode), rasterizing it on first use. The
+// quad is scaled by *scale, which is only not 1 for fallback glyphs. NULL if there is nothing to
+// draw yet.
+const SGlyph* getGlyph(SGlyphCache* cache, SFontSize* size, STextMode mode, int codepoint, float* scale) {
+    SGlyph* glyph;
+    *scale = 1.0f;
+
+    if (codepoint >= 32 && codepoint < 127) {
+        if (size->asciiGeneration != cache->generation || size->asciiMode != mode) {
+            memset(size->ascii, 0, sizeof(size->ascii));
+            size->asciiGeneration = cache->generation;
+            size->asciiMode = mode;
+        }
+
+        int index = size->ascii[codepoint - 32];
+        if (index) {
+            glyph = &cache->glyphs[index - 1];
+        } else {
+            glyph = findOrRasterizeGlyph(cache, size, mode, codepoint);
+            if (!glyph) {
+                return NULL;
+            }
+            // Rasterizing can evict a page, which invalidates every index.
+            if (size->asciiGeneration == cache->generation) {
+                size->ascii[codepoint - 32] = (int)(glyph - cache->glyphs) + 1;
+            }
+        }
+    } else {
+        glyph = findOrRasterizeGlyph(cache, size, mode, codepoint);
+        if (!glyph) {
+            return NULL;
+        }
+    }
+
+    if (glyph->page >= 0) {
+        cache->pages[glyph->page].lastUsed = cache->tick;
+    }
+    if (!glyph->pending) {
+        return glyph;
+    }
+    if (glyphWorkers.mode != SGLYPH_LOAD_FALLBACK) {
+        return NULL;
+    }
+
+    // Stand in with the same glyph at the fallback size, rasterized right away since it is small.
+    // The page of the pending glyph is marked used above, so this cannot evict it.
+    SFontSize fallback = *size;
+    fallback.pixelSize = STDUI_GLYPH_FALLBACK_SIZE;
+    fallback.scale = fontScaleForPixelHeight(size->font, (float)STDUI_GLYPH_FALLBACK_SIZE);
+    glyph = findOrRasterizeGlyph(cache, &fallback, mode, codepoint);
+    if (!glyph) {
+        return NULL;
+    }
+    if (glyph->page >= 0) {
+        cache->pages[glyph->page].lastUsed = cache->tick;
+    }
+    *scale = size->scale / fallback.scale;
+    return glyph;
+}
+
+#endif //FONT_H
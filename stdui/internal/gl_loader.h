@@ -0,0 +1,328 @@
+#ifndef GL_LOADER_H
+#define GL_LOADER_H
+//Copyright (C) <2025>  <Wickslynx>
+
+// OpenGL entry points past 1.1 and the capability tiers built on top of 3.3 core (ES 3.0).
+// SLoadGL() checks the context version and resolves everything once, the first time a context
+// is current. The renderer then picks a fast path per tier and keeps the plain 3.3 path when a
+// tier is missing. Desktop GL libraries only have to export 1.1, opengl32.dll exports nothing
+// newer, so the 3.3 functions stdui calls are resolved as well and reached through the macros
+// below. libGLESv2 exports all of ES 3.0, those are called directly.
+// Include after the GL headers, window.h and widgets.h do.
+
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+
+#if defined(_WIN32) || defined(_WIN64)
+#define STDUI_GLAPI __stdcall
+#else
+#define STDUI_GLAPI
+#endif
+
+// Tokens missing from GL 3.3 and ES 3.0 headers.
+#ifndef GL_MAP_PERSISTENT_BIT
+#define GL_MAP_PERSISTENT_BIT 0x0040
+#endif
+#ifndef GL_MAP_COHERENT_BIT
+#define GL_MAP_COHERENT_BIT 0x0080
+#endif
+#ifndef GL_DYNAMIC_STORAGE_BIT
+#define GL_DYNAMIC_STORAGE_BIT 0x0100
+#endif
+#ifndef GL_DEBUG_OUTPUT
+#define GL_DEBUG_OUTPUT 0x92E0
+#endif
+#ifndef GL_DEBUG_SEVERITY_NOTIFICATION
+#define GL_DEBUG_SEVERITY_NOTIFICATION 0x826B
+#endif
+#ifndef GL_TIMESTAMP
+#define GL_TIMESTAMP 0x8E28
+#endif
+
+typedef void (STDUI_GLAPI *SGLDebugProc)(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                         GLsizei length, const GLchar* message, const void* user);
+
+typedef void (STDUI_GLAPI *SGLCreateBuffersProc)(GLsizei n, GLuint* buffers);
+typedef void (STDUI_GLAPI *SGLNamedBufferDataProc)(GLuint buffer, GLsizeiptr size, const void* data, GLenum usage);
+typedef void (STDUI_GLAPI *SGLNamedBufferSubDataProc)(GLuint buffer, GLintptr offset, GLsizeiptr size,
+                                                      const void* data);
+typedef void (STDUI_GLAPI *SGLCopyNamedBufferSubDataProc)(GLuint readBuffer, GLuint writeBuffer, GLintptr readOffset,
+                                                          GLintptr writeOffset, GLsizeiptr size);
+typedef void (STDUI_GLAPI *SGLBufferStorageProc)(GLenum target, GLsizeiptr size, const void* data, GLbitfield flags);
+typedef void (STDUI_GLAPI *SGLMultiDrawArraysIndirectProc)(GLenum mode, const void* indirect, GLsizei count,
+                                                           GLsizei stride);
+typedef void (STDUI_GLAPI *SGLMultiDrawElementsIndirectProc)(GLenum mode, GLenum type, const void* indirect,
+                                                             GLsizei count, GLsizei stride);
+typedef void (STDUI_GLAPI *SGLTexStorage2DProc)(GLenum target, GLsizei levels, GLenum internalformat,
+                                                GLsizei width, GLsizei height);
+typedef void (STDUI_GLAPI *SGLTexStorage3DProc)(GLenum target, GLsizei levels, GLenum internalformat,
+                                                GLsizei width, GLsizei height, GLsizei depth);
+typedef void (STDUI_GLAPI *SGLQueryCounterProc)(GLuint id, GLenum target);
+typedef void (STDUI_GLAPI *SGLGetQueryObjectui64vProc)(GLuint id, GLenum pname, GLuint64* params);
+typedef void (STDUI_GLAPI *SGLDebugMessageCallbackProc)(SGLDebugProc callback, const void* user);
+
+#ifndef STDUI_GLES
+// Type and name without the gl prefix of every core function SLoadGL() resolves.
+#define STDUI_GL_CORE_FUNCTIONS(X) \
+    X(PFNGLACTIVETEXTUREPROC, ActiveTexture) \
+    X(PFNGLATTACHSHADERPROC, AttachShader) \
+    X(PFNGLBINDBUFFERPROC, BindBuffer) \
+    X(PFNGLBINDVERTEXARRAYPROC, BindVertexArray) \
+    X(PFNGLBUFFERDATAPROC, BufferData) \
+    X(PFNGLBUFFERSUBDATAPROC, BufferSubData) \
+    X(PFNGLCLIENTWAITSYNCPROC, ClientWaitSync) \
+    X(PFNGLCOMPILESHADERPROC, CompileShader) \
+    X(PFNGLCOPYBUFFERSUBDATAPROC, CopyBufferSubData) \
+    X(PFNGLCREATEPROGRAMPROC, CreateProgram) \
+    X(PFNGLCREATESHADERPROC, CreateShader) \
+    X(PFNGLDELETEBUFFERSPROC, DeleteBuffers) \
+    X(PFNGLDELETEPROGRAMPROC, DeleteProgram) \
+    X(PFNGLDELETESHADERPROC, DeleteShader) \
+    X(PFNGLDELETESYNCPROC, DeleteSync) \
+    X(PFNGLDELETEVERTEXARRAYSPROC, DeleteVertexArrays) \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC, DrawArraysInstanced) \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, EnableVertexAttribArray) \
+    X(PFNGLFENCESYNCPROC, FenceSync) \
+    X(PFNGLGENBUFFERSPROC, GenBuffers) \
+    X(PFNGLGENVERTEXARRAYSPROC, GenVertexArrays) \
+    X(PFNGLGETPROGRAMINFOLOGPROC, GetProgramInfoLog) \
+    X(PFNGLGETPROGRAMIVPROC, GetProgramiv) \
+    X(PFNGLGETSHADERINFOLOGPROC, GetShaderInfoLog) \
+    X(PFNGLGETSHADERIVPROC, GetShaderiv) \
+    X(PFNGLGETSTRINGIPROC, GetStringi) \
+    X(PFNGLGETUNIFORMLOCATIONPROC, GetUniformLocation) \
+    X(PFNGLLINKPROGRAMPROC, LinkProgram) \
+    X(PFNGLMAPBUFFERRANGEPROC, MapBufferRange) \
+    X(PFNGLSHADERSOURCEPROC, ShaderSource) \
+    X(PFNGLTEXIMAGE3DPROC, TexImage3D) \
+    X(PFNGLTEXSUBIMAGE3DPROC, TexSubImage3D) \
+    X(PFNGLUNIFORM1IPROC, Uniform1i) \
+    X(PFNGLUNIFORM2FPROC, Uniform2f) \
+    X(PFNGLUNIFORM2IPROC, Uniform2i) \
+    X(PFNGLUNIFORM3FPROC, Uniform3f) \
+    X(PFNGLUNIFORM4FPROC, Uniform4f) \
+    X(PFNGLUNIFORMMATRIX4FVPROC, UniformMatrix4fv) \
+    X(PFNGLUSEPROGRAMPROC, UseProgram) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC, VertexAttribDivisor) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC, VertexAttribPointer)
+#else
+#define STDUI_GL_CORE_FUNCTIONS(X)
+#endif
+
+#define STDUI_GL_DECLARE_CORE(type, name) type name;
+
+typedef struct {
+    int major, minor;        // Context version, ES versions when es is set.
+    bool es;
+    bool loaded;             // SLoadGL() ran for the current process.
+    unsigned int generation; // Counts the loads. Objects made under an older one went with its contexts.
+
+    // Tiers, each one is only set when all of its functions resolved.
+    bool directStateAccess;  // 4.5 or ARB_direct_state_access.
+    bool bufferStorage;      // 4.4, ARB_buffer_storage or EXT_buffer_storage.
+    bool multiDrawIndirect;  // 4.3, ARB_multi_draw_indirect or EXT_multi_draw_indirect.
+    bool textureStorage;     // 4.2, ARB_texture_storage or ES 3.0.
+    bool timerQuery;         // 3.3 or EXT_disjoint_timer_query.
+    bool debugOutput;        // 4.3 or KHR_debug.
+
+    SGLCreateBuffersProc CreateBuffers;
+    SGLNamedBufferDataProc NamedBufferData;
+    SGLNamedBufferSubDataProc NamedBufferSubData;
+    SGLCopyNamedBufferSubDataProc CopyNamedBufferSubData;
+    SGLBufferStorageProc BufferStorage;
+    SGLMultiDrawArraysIndirectProc MultiDrawArraysIndirect;
+    SGLMultiDrawElementsIndirectProc MultiDrawElementsIndirect;
+    SGLTexStorage2DProc TexStorage2D;
+    SGLTexStorage3DProc TexStorage3D;
+    SGLQueryCounterProc QueryCounter;
+    SGLGetQueryObjectui64vProc GetQueryObjectui64v;
+    SGLDebugMessageCallbackProc DebugMessageCallback;
+
+    STDUI_GL_CORE_FUNCTIONS(STDUI_GL_DECLARE_CORE) // Always set once loaded.
+} SGLCapabilities;
+
+SGLCapabilities stduiGL;
+
+#ifndef STDUI_GLES
+#define glActiveTexture stduiGL.ActiveTexture
+#define glAttachShader stduiGL.AttachShader
+#define glBindBuffer stduiGL.BindBuffer
+#define glBindVertexArray stduiGL.BindVertexArray
+#define glBufferData stduiGL.BufferData
+#define glBufferSubData stduiGL.BufferSubData
+#define glClientWaitSync stduiGL.ClientWaitSync
+#define glCompileShader stduiGL.CompileShader
+#define glCopyBufferSubData stduiGL.CopyBufferSubData
+#define glCreateProgram stduiGL.CreateProgram
+#define glCreateShader stduiGL.CreateShader
+#define glDeleteBuffers stduiGL.DeleteBuffers
+#define glDeleteProgram stduiGL.DeleteProgram
+#define glDeleteShader stduiGL.DeleteShader
+#define glDeleteSync stduiGL.DeleteSync
+#define glDeleteVertexArrays stduiGL.DeleteVertexArrays
+#define glDrawArraysInstanced stduiGL.DrawArraysInstanced
+#define glEnableVertexAttribArray stduiGL.EnableVertexAttribArray
+#define glFenceSync stduiGL.FenceSync
+#define glGenBuffers stduiGL.GenBuffers
+#define glGenVertexArrays stduiGL.GenVertexArrays
+#define glGetProgramInfoLog stduiGL.GetProgramInfoLog
+#define glGetProgramiv stduiGL.GetProgramiv
+#define glGetShaderInfoLog stduiGL.GetShaderInfoLog
+#define glGetShaderiv stduiGL.GetShaderiv
+#define glGetStringi stduiGL.GetStringi
+#define glGetUniformLocation stduiGL.GetUniformLocation
+#define glLinkProgram stduiGL.LinkProgram
+#define glMapBufferRange stduiGL.MapBufferRange
+#define glShaderSource stduiGL.ShaderSource
+#define glTexImage3D stduiGL.TexImage3D
+#define glTexSubImage3D stduiGL.TexSubImage3D
+#define glUniform1i stduiGL.Uniform1i
+#define glUniform2f stduiGL.Uniform2f
+#define glUniform2i stduiGL.Uniform2i
+#define glUniform3f stduiGL.Uniform3f
+#define glUniform4f stduiGL.Uniform4f
+#define glUniformMatrix4fv stduiGL.UniformMatrix4fv
+#define glUseProgram stduiGL.UseProgram
+#define glVertexAttribDivisor stduiGL.VertexAttribDivisor
+#define glVertexAttribPointer stduiGL.VertexAttribPointer
+#endif
+
+static void* getGLProcAddress(const char* name) {
+#if defined(_WIN32) || defined(_WIN64)
+    return (void*)wglGetProcAddress(name);
+#elif defined(__linux__) && (defined(STDUI_WAYLAND) || defined(STDUI_GLES))
+    return (void*)eglGetProcAddress(name);
+#elif defined(__linux__)
+    return (void*)glXGetProcAddress((const GLubyte*)name);
+#else
+    return NULL;
+#endif
+}
+
+// The core name first, then the extension name ES drivers export it under.
+static void* loadGLProc(const char* name, const char* extensionName) {
+    void* proc = getGLProcAddress(name);
+    if (proc == NULL && extensionName) {
+        proc = getGLProcAddress(extensionName);
+    }
+    return proc;
+}
+
+static bool hasGLExtension(const char* name) {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+    for (GLint i = 0; i < count; i++) {
+        const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, (GLuint)i);
+        if (extension && strcmp(extension, name) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool glVersionAtLeast(int major, int minor) {
+    return stduiGL.major > major || (stduiGL.major == major && stduiGL.minor >= minor);
+}
+
+// Check the current context and resolve the tiers. Later calls return at once, the pointers
+// are the same for every context of the process. Returns false below GL 3.3 or ES 3.0.
+bool SLoadGL(void) {
+    if (stduiGL.loaded) {
+        return true;
+    }
+
+    const char* version = (const char*)glGetString(GL_VERSION);
+    if (version == NULL) {
+        fprintf(stderr, "ERROR: No current OpenGL context to load functions for.\n");
+        return false;
+    }
+
+    unsigned int generation = stduiGL.generation;
+    memset(&stduiGL, 0, sizeof(stduiGL));
+    stduiGL.generation = generation + 1;
+    stduiGL.es = strncmp(version, "OpenGL ES", 9) == 0;
+    glGetIntegerv(GL_MAJOR_VERSION, &stduiGL.major);
+    glGetIntegerv(GL_MINOR_VERSION, &stduiGL.minor);
+    if (stduiGL.es ? stduiGL.major < 3 : !glVersionAtLeast(3, 3)) {
+        fprintf(stderr, "ERROR: OpenGL %s is required. Detected version: %s\n", stduiGL.es ? "ES 3.0" : "3.3", version);
+        return false;
+    }
+
+    // Resolved before hasGLExtension(), it needs glGetStringi().
+    const char* missing = NULL;
+    #define STDUI_GL_LOAD_CORE(type, name) \
+        stduiGL.name = (type)getGLProcAddress("gl" #name); \
+        if (stduiGL.name == NULL && missing == NULL) missing = "gl" #name;
+    STDUI_GL_CORE_FUNCTIONS(STDUI_GL_LOAD_CORE)
+    #undef STDUI_GL_LOAD_CORE
+    if (missing) {
+        fprintf(stderr, "ERROR: The OpenGL driver does not provide %s.\n", missing);
+        return false;
+    }
+
+    if (!stduiGL.es && (glVersionAtLeast(4, 5) || hasGLExtension("GL_ARB_direct_state_access"))) {
+        stduiGL.CreateBuffers = (SGLCreateBuffersProc)loadGLProc("glCreateBuffers", NULL);
+        stduiGL.NamedBufferData = (SGLNamedBufferDataProc)loadGLProc("glNamedBufferData", NULL);
+        stduiGL.NamedBufferSubData = (SGLNamedBufferSubDataProc)loadGLProc("glNamedBufferSubData", NULL);
+        stduiGL.CopyNamedBufferSubData = (SGLCopyNamedBufferSubDataProc)loadGLProc("glCopyNamedBufferSubData", NULL);
+        stduiGL.directStateAccess = stduiGL.CreateBuffers && stduiGL.NamedBufferData &&
+                                    stduiGL.NamedBufferSubData && stduiGL.CopyNamedBufferSubData;
+    }
+
+    if (stduiGL.es ? hasGLExtension("GL_EXT_buffer_storage")
+                   : glVersionAtLeast(4, 4) || hasGLExtension("GL_ARB_buffer_storage")) {
+        stduiGL.BufferStorage = (SGLBufferStorageProc)loadGLProc("glBufferStorage", "glBufferStorageEXT");
+        stduiGL.bufferStorage = stduiGL.BufferStorage != NULL;
+    }
+
+    if (stduiGL.es ? hasGLExtension("GL_EXT_multi_draw_indirect")
+                   : glVersionAtLeast(4, 3) || hasGLExtension("GL_ARB_multi_draw_indirect")) {
+        stduiGL.MultiDrawArraysIndirect = (SGLMultiDrawArraysIndirectProc)
+            loadGLProc("glMultiDrawArraysIndirect", "glMultiDrawArraysIndirectEXT");
+        stduiGL.MultiDrawElementsIndirect = (SGLMultiDrawElementsIndirectProc)
+            loadGLProc("glMultiDrawElementsIndirect", "glMultiDrawElementsIndirectEXT");
+        stduiGL.multiDrawIndirect = stduiGL.MultiDrawArraysIndirect && stduiGL.MultiDrawElementsIndirect;
+    }
+
+    if (stduiGL.es || glVersionAtLeast(4, 2) || hasGLExtension("GL_ARB_texture_storage")) {
+        stduiGL.TexStorage2D = (SGLTexStorage2DProc)loadGLProc("glTexStorage2D", NULL);
+        stduiGL.TexStorage3D = (SGLTexStorage3DProc)loadGLProc("glTexStorage3D", NULL);
+#ifdef STDUI_GLES
+        // Core in ES 3.0, eglGetProcAddress() only has to know extension functions.
+        if (stduiGL.TexStorage2D == NULL) stduiGL.TexStorage2D = glTexStorage2D;
+        if (stduiGL.TexStorage3D == NULL) stduiGL.TexStorage3D = glTexStorage3D;
+#endif
+        stduiGL.textureStorage = stduiGL.TexStorage2D && stduiGL.TexStorage3D;
+    }
+
+    if (!stduiGL.es || hasGLExtension("GL_EXT_disjoint_timer_query")) {
+        stduiGL.QueryCounter = (SGLQueryCounterProc)loadGLProc("glQueryCounter", "glQueryCounterEXT");
+        stduiGL.GetQueryObjectui64v = (SGLGetQueryObjectui64vProc)
+            loadGLProc("glGetQueryObjectui64v", "glGetQueryObjectui64vEXT");
+        stduiGL.timerQuery = stduiGL.QueryCounter && stduiGL.GetQueryObjectui64v;
+    }
+
+    if (glVersionAtLeast(stduiGL.es ? 3 : 4, stduiGL.es ? 2 : 3) || hasGLExtension("GL_KHR_debug")) {
+        stduiGL.DebugMessageCallback = (SGLDebugMessageCallbackProc)
+            loadGLProc("glDebugMessageCallback", "glDebugMessageCallbackKHR");
+        stduiGL.debugOutput = stduiGL.DebugMessageCallback != NULL;
+    }
+
+    stduiGL.loaded = true;
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: OpenGL %s%d.%d, DSA %d, buffer storage %d, multi draw indirect %d, texture storage %d, "
+           "timer query %d, debug output %d\n", stduiGL.es ? "ES " : "", stduiGL.major, stduiGL.minor,
+           stduiGL.directStateAccess, stduiGL.bufferStorage, stduiGL.multiDrawIndirect,
+           stduiGL.textureStorage, stduiGL.timerQuery, stduiGL.debugOutput);
+    #endif
+    return true;
+}
+
+// What the current process resolved, NULL before the first window exists.
+static inline const SGLCapabilities* SGetGLCapabilities(void) {
+    return stduiGL.loaded ? &stduiGL : NULL;
+}
+
+#endif // GL_LOADER_H
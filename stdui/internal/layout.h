@@ -1,4 +1,776 @@
 #ifndef LAYOUT_H
 #define LAYOUT_H
+//Copyright (C) <2025>  <Wickslynx>
 
+// Text layout.
+// A laid out string (a run) stores the pen position of every glyph and its line breaks.
+// Runs are cached by (string, font, mode, pixel size, wrap width) so labels drawn every frame
+// are only laid out once.
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "font.h"
+
+#ifndef STDUI_TEXT_RUN_CACHE_SIZE
+#define STDUI_TEXT_RUN_CACHE_SIZE 256 // Must be a power of two.
 #endif
+#define STDUI_TEXT_RUN_WAYS 4         // Runs a string can be stored in, the oldest one is replaced.
+
+typedef struct {
+    int codepoint;
+    float x, y; // Pen position, y is the baseline relative to the first baseline.
+} SRunGlyph;
+
+typedef struct {
+    int firstGlyph, glyphCount;
+    float width;
+} SRunLine;
+
+typedef struct {
+    uint64_t hash;
+    char* text;
+    int length;
+    SFont* font;
+    STextMode mode;
+    int pixelSize;
+    float wrapWidth;
+
+    SRunGlyph* glyphs;
+    int glyphCount;
+    SRunLine* lines;
+    int lineCount;
+    float width, height;
+
+    unsigned int lastUsed;
+} STextRun;
+
+typedef struct {
+    unsigned long hits;
+    unsigned long misses;
+} STextCacheStats;
+
+STextRun textRuns[STDUI_TEXT_RUN_CACHE_SIZE];
+STextCacheStats textCacheStats;
+unsigned int textRunTick = 0;
+
+
+// A string as the run cache looks it up. Text drawn every frame can keep its key from
+// SMakeTextKey() so the draw skips measuring and hashing it.
+typedef struct {
+    const char* text;
+    int length;
+    uint64_t hash;
+} STextKey;
+
+static inline uint64_t hashText(const char* text, int length) {
+    uint64_t hash = 0xcbf29ce484222325ULL; // FNV-1a
+    for (int i = 0; i < length; i++) {
+        hash ^= (unsigned char)text[i];
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+// length < 0 takes the text up to its terminator. The text must stay valid while the key is used.
+STextKey SMakeTextKey(const char* text, int length) {
+    STextKey key;
+    key.text = text;
+    key.length = length < 0 ? (int)strlen(text) : length;
+    key.hash = hashText(text, key.length);
+    return key;
+}
+
+static void freeTextRun(STextRun* run) {
+    free(run->text);
+    free(run->glyphs);
+    free(run->lines);
+    memset(run, 0, sizeof(*run));
+}
+
+static bool pushRunLine(STextRun* run, int* capacity, int firstGlyph, int glyphCount, float width) {
+    if (run->lineCount >= *capacity) {
+        int newCapacity = *capacity ? *capacity * 2 : 4;
+        SRunLine* lines = (SRunLine*)realloc(run->lines, newCapacity * sizeof(SRunLine));
+        if (!lines) {
+            return false;
+        }
+        run->lines = lines;
+        *capacity = newCapacity;
+    }
+    SRunLine* line = &run->lines[run->lineCount++];
+    line->firstGlyph = firstGlyph;
+    line->glyphCount = glyphCount;
+    line->width = width;
+    return true;
+}
+
+// Lay out a string, breaking on '\n' and, if wrapWidth > 0, greedily at spaces.
+static bool layoutTextRun(STextRun* run, SFontSize* size, const char* text, int length, float wrapWidth) {
+    const SFont* font = size->font;
+
+    // A glyph per byte is always enough.
+    run->glyphs = (SRunGlyph*)malloc((length + 1) * sizeof(SRunGlyph));
+    if (!run->glyphs) {
+        return false;
+    }
+    int lineCapacity = 0;
+
+    const char* end = text + length;
+    float penX = 0.0f, penY = 0.0f;
+    int lineStart = 0;
+    int prev = 0, prevGlyph = 0;
+
+    // Last space seen on the current line, the line is broken there when it gets too wide.
+    int breakGlyph = -1;
+    float breakX = 0.0f;
+
+    while (text < end) {
+        int c = decodeUTF8(&text, end);
+
+        if (c == '\n') {
+            if (!pushRunLine(run, &lineCapacity, lineStart, run->glyphCount - lineStart, penX)) return false;
+            penX = 0.0f;
+            penY += size->lineHeight;
+            lineStart = run->glyphCount;
+            breakGlyph = -1;
+            prev = 0;
+            continue;
+        }
+
+        if (c < 32 || c == 127) {
+            continue;
+        }
+
+        int glyphIndex = fontGlyphIndex(font, c);
+        int advance = fontGlyphAdvance(font, glyphIndex);
+        penX += kernAdvance(size, prev, c, prevGlyph, glyphIndex);
+        prev = c;
+        prevGlyph = glyphIndex;
+
+        if (c == ' ') {
+            breakGlyph = run->glyphCount;
+            breakX = penX;
+            penX += advance * size->scale;
+            continue;
+        }
+
+        float right = penX + advance * size->scale;
+        if (wrapWidth > 0.0f && right > wrapWidth && run->glyphCount > lineStart) {
+            // Break at the last space, or mid word if the word alone is wider than the wrap width.
+            int next = breakGlyph >= 0 ? breakGlyph : run->glyphCount;
+            float lineWidth = breakGlyph >= 0 ? breakX : penX;
+            float shift = run->glyphCount > next ? run->glyphs[next].x : penX;
+
+            if (!pushRunLine(run, &lineCapacity, lineStart, next - lineStart, lineWidth)) return false;
+            penY += size->lineHeight;
+            for (int i = next; i < run->glyphCount; i++) {
+                run->glyphs[i].x -= shift;
+                run->glyphs[i].y = penY;
+            }
+            penX -= shift;
+            right -= shift;
+            lineStart = next;
+            breakGlyph = -1;
+        }
+
+        SRunGlyph* glyph = &run->glyphs[run->glyphCount++];
+        glyph->codepoint = c;
+        glyph->x = penX;
+        glyph->y = penY;
+        penX = right;
+    }
+
+    // Trailing spaces do not count towards the width.
+    float lastWidth = run->glyphCount > lineStart ? penX : 0.0f;
+    if (breakGlyph == run->glyphCount && run->glyphCount > lineStart) {
+        lastWidth = breakX;
+    }
+    if (!pushRunLine(run, &lineCapacity, lineStart, run->glyphCount - lineStart, lastWidth)) return false;
+
+    run->width = 0.0f;
+    for (int i = 0; i < run->lineCount; i++) {
+        if (run->lines[i].width > run->width) {
+            run->width = run->lines[i].width;
+        }
+    }
+    run->height = run->lineCount * size->lineHeight;
+    return true;
+}
+
+// Get the cached layout of a string, laying it out on a miss. Returns NULL on allocation failure.
+const STextRun* getTextRun(SFontSize* size, const STextKey* key, float wrapWidth) {
+    const char* text = key->text;
+    int length = key->length;
+    STextMode mode = size->font->mode;
+    uint64_t hash = key->hash ^ ((uint64_t)mode << 58) ^ ((uint64_t)size->font->id << 40) ^
+                    ((uint64_t)size->pixelSize << 24) ^ (uint64_t)(wrapWidth * 16.0f);
+
+    textRunTick++;
+    unsigned int first = (unsigned int)hash & (STDUI_TEXT_RUN_CACHE_SIZE - 1);
+    STextRun* oldest = NULL;
+
+    for (int way = 0; way < STDUI_TEXT_RUN_WAYS; way++) {
+        STextRun* run = &textRuns[(first + way) & (STDUI_TEXT_RUN_CACHE_SIZE - 1)];
+        if (run->text && run->hash == hash && run->font == size->font && run->mode == mode &&
+            run->pixelSize == size->pixelSize &&
+            run->wrapWidth == wrapWidth && run->length == length && memcmp(run->text, text, length) == 0) {
+            run->lastUsed = textRunTick;
+            textCacheStats.hits++;
+            return run;
+        }
+        if (!oldest || !run->text || (oldest->text && run->lastUsed < oldest->lastUsed)) {
+            oldest = run;
+        }
+    }
+
+    textCacheStats.misses++;
+    freeTextRun(oldest);
+
+    oldest->text = (char*)malloc(length + 1);
+    if (!oldest->text) {
+        return NULL;
+    }
+    memcpy(oldest->text, text, length);
+    oldest->text[length] = '\0';
+    oldest->hash = hash;
+    oldest->length = length;
+    oldest->font = size->font;
+    oldest->mode = mode;
+    oldest->pixelSize = size->pixelSize;
+    oldest->wrapWidth = wrapWidth;
+    oldest->lastUsed = textRunTick;
+
+    // From the copy, the caller's text may go on past length.
+    if (!layoutTextRun(oldest, size, oldest->text, length, wrapWidth)) {
+        fprintf(stderr, "ERROR: Failed to allocate text layout\n");
+        freeTextRun(oldest);
+        return NULL;
+    }
+    return oldest;
+}
+
+void clearTextRunCache() {
+    for (int i = 0; i < STDUI_TEXT_RUN_CACHE_SIZE; i++) {
+        freeTextRun(&textRuns[i]);
+    }
+}
+
+// Hit/miss counters of the text layout cache since startup (or the last reset).
+STextCacheStats SGetTextCacheStats() {
+    return textCacheStats;
+}
+
+void SResetTextCacheStats() {
+    textCacheStats.hits = 0;
+    textCacheStats.misses = 0;
+}
+
+
+// Paragraphs.
+// A paragraph is retained text that is broken into lines to fit a width. The text is split
+// into words that are measured once, and the words of each hard line (text between '\n')
+// form a block. Appending only measures the new words and breaks the last block again from
+// the start of its last line, and a width change only re-breaks the blocks that are wider
+// than the old or the new width.
+
+typedef enum {
+    STEXT_ALIGN_LEFT,
+    STEXT_ALIGN_CENTER,
+    STEXT_ALIGN_RIGHT
+} STextAlign;
+
+typedef enum {
+    STEXT_WRAP_GREEDY,   // Fill each line as far as it goes.
+    STEXT_WRAP_BALANCED  // Same number of lines as greedy, but with line widths as even as possible.
+} STextWrap;
+
+typedef struct {
+    int codepoint;
+    float wordX;   // Position inside the word.
+    float x;       // Position inside the line, set when the block is broken.
+    float advance;
+} SParaGlyph;
+
+typedef struct {
+    int firstGlyph, glyphCount;
+    int textStart;      // Byte offset of the word in the paragraph text.
+    float width;
+    float spaceWidth;   // Width of the spaces following the word.
+    bool closed;        // Spaces were seen after it, new glyphs start a new word.
+} SParaWord;
+
+typedef struct {
+    int firstGlyph, glyphCount;
+    float width;
+} SParaLine;
+
+typedef struct {
+    int firstWord, wordCount;
+    int firstLine, lineCount;
+    float naturalWidth; // Width of the block on one line.
+    bool dirty;
+    bool appended;      // Only words after the last line start changed, see layoutParaBlock().
+
+    // naturalWidth of every word but the last one, which an append can still extend.
+    int measuredWords;
+    float measuredWidth, measuredSpace;
+
+    // Where the last line that starts on a word boundary begins, breaking resumes there.
+    int resumeWord, resumeLine;
+} SParaBlock;
+
+typedef struct {
+    SFont* font;
+    int pixelSize;
+
+    char* text;
+    int length, textCapacity;
+
+    SParaGlyph* glyphs;
+    int glyphCount, glyphCapacity;
+    SParaWord* words;
+    int wordCount, wordCapacity;
+    SParaBlock* blocks;
+    int blockCount, blockCapacity;
+    SParaLine* lines;
+    int lineCount, lineCapacity;
+
+    float maxWidth;    // <= 0 disables wrapping.
+    float maxHeight;   // <= 0 shows every line.
+    float layoutWidth; // maxWidth the current lines were broken for.
+    STextAlign align;
+    STextWrap wrap;
+    bool ellipsis;     // End the last visible line with "..." when lines are cut off.
+    bool relayout;     // Every block has to be broken again.
+    int firstDirtyBlock;
+} SParagraph;
+
+// Grow an array so it holds at least count elements.
+static bool reserveArray(void** data, int* capacity, int count, size_t elementSize) {
+    if (count <= *capacity) {
+        return true;
+    }
+    int newCapacity = *capacity ? *capacity : 16;
+    while (newCapacity < count) {
+        newCapacity *= 2;
+    }
+    void* grown = realloc(*data, newCapacity * elementSize);
+    if (!grown) {
+        fprintf(stderr, "ERROR: Failed to grow paragraph storage\n");
+        return false;
+    }
+    *data = grown;
+    *capacity = newCapacity;
+    return true;
+}
+
+SParagraph* SCreateParagraph(SFont* font, float scale) {
+    if (font == NULL) {
+        font = currentFont;
+    }
+    if (font == NULL) {
+        fprintf(stderr, "ERROR: No font loaded for the paragraph\n");
+        return NULL;
+    }
+
+    SParagraph* paragraph = (SParagraph*)calloc(1, sizeof(SParagraph));
+    if (!paragraph) {
+        return NULL;
+    }
+    paragraph->font = font;
+    paragraph->pixelSize = getFontSize(font, STDUI_DEFAULT_FONT_SIZE * scale)->pixelSize;
+    paragraph->align = STEXT_ALIGN_LEFT;
+    paragraph->wrap = STEXT_WRAP_GREEDY;
+
+    // A paragraph always has at least one (possibly empty) block.
+    if (!reserveArray((void**)&paragraph->blocks, &paragraph->blockCapacity, 1, sizeof(SParaBlock))) {
+        free(paragraph);
+        return NULL;
+    }
+    memset(&paragraph->blocks[0], 0, sizeof(SParaBlock));
+    paragraph->blocks[0].dirty = true;
+    paragraph->blockCount = 1;
+    paragraph->firstDirtyBlock = 0;
+    return paragraph;
+}
+
+void SDestroyParagraph(SParagraph* paragraph) {
+    if (!paragraph) {
+        return;
+    }
+    free(paragraph->text);
+    free(paragraph->glyphs);
+    free(paragraph->words);
+    free(paragraph->blocks);
+    free(paragraph->lines);
+    free(paragraph);
+}
+
+static SParaWord* pushParaWord(SParagraph* p, int textStart) {
+    if (!reserveArray((void**)&p->words, &p->wordCapacity, p->wordCount + 1, sizeof(SParaWord))) {
+        return NULL;
+    }
+    SParaWord* word = &p->words[p->wordCount++];
+    word->firstGlyph = p->glyphCount;
+    word->glyphCount = 0;
+    word->textStart = textStart;
+    word->width = 0.0f;
+    word->spaceWidth = 0.0f;
+    word->closed = false;
+    p->blocks[p->blockCount - 1].wordCount++;
+    return word;
+}
+
+// Split text starting at byte offset start into words and blocks.
+static bool measureParagraphText(SParagraph* p, int start) {
+    SFontSize* size = getFontSize(p->font, (float)p->pixelSize);
+    const SFont* font = p->font;
+    const char* text = p->text + start;
+    const char* end = p->text + p->length;
+
+    SParaBlock* block = &p->blocks[p->blockCount - 1];
+    SParaWord* word = block->wordCount ? &p->words[p->wordCount - 1] : NULL;
+    int prev = 0, prevGlyph = 0;
+
+    while (text < end) {
+        int offset = (int)(text - p->text);
+        int c = decodeUTF8(&text, end);
+
+        if (c == '\n') {
+            if (!reserveArray((void**)&p->blocks, &p->blockCapacity, p->blockCount + 1, sizeof(SParaBlock))) {
+                return false;
+            }
+            block = &p->blocks[p->blockCount++];
+            memset(block, 0, sizeof(*block));
+            block->firstWord = p->wordCount;
+            block->firstLine = p->lineCount;
+            block->dirty = true;
+            word = NULL;
+            prev = 0;
+            continue;
+        }
+
+        if (c < 32 || c == 127) {
+            continue;
+        }
+
+        int glyphIndex = fontGlyphIndex(font, c);
+        int advance = fontGlyphAdvance(font, glyphIndex);
+
+        if (c == ' ') {
+            if (!word && !(word = pushParaWord(p, offset))) {
+                return false;
+            }
+            word->spaceWidth += advance * size->scale;
+            word->closed = true;
+            prev = 0;
+            continue;
+        }
+
+        if (!word || word->closed) {
+            if (!(word = pushParaWord(p, offset))) {
+                return false;
+            }
+            prev = 0;
+        }
+        if (!reserveArray((void**)&p->glyphs, &p->glyphCapacity, p->glyphCount + 1, sizeof(SParaGlyph))) {
+            return false;
+        }
+
+        float x = word->width + kernAdvance(size, prev, c, prevGlyph, glyphIndex);
+        prev = c;
+        prevGlyph = glyphIndex;
+
+        SParaGlyph* glyph = &p->glyphs[p->glyphCount++];
+        glyph->codepoint = c;
+        glyph->wordX = x;
+        glyph->x = x;
+        glyph->advance = advance * size->scale;
+        word->glyphCount++;
+        word->width = x + glyph->advance;
+    }
+    return true;
+}
+
+// Append text to the paragraph. Only the new text (and the word it continues) is measured,
+// and the last block is only broken again from its last line on. Returns false when the
+// paragraph storage could not grow, the paragraph keeps what was measured until then.
+bool SParagraphAppend(SParagraph* p, const char* text) {
+    if (!p || !text) {
+        return false;
+    }
+    int added = (int)strlen(text);
+    if (added == 0) {
+        return true;
+    }
+    if (!reserveArray((void**)&p->text, &p->textCapacity, p->length + added + 1, 1)) {
+        return false;
+    }
+
+    // An open word at the end may continue in the new text, measure it again.
+    int start = p->length;
+    SParaBlock* last = &p->blocks[p->blockCount - 1];
+    if (last->wordCount > 0) {
+        SParaWord* word = &p->words[p->wordCount - 1];
+        if (!word->closed) {
+            start = word->textStart;
+            p->glyphCount = word->firstGlyph;
+            p->wordCount--;
+            last->wordCount--;
+        }
+    }
+    // Lines before the last one stay valid, breaking resumes from there.
+    last->appended = true;
+    last->dirty = true;
+    if (p->firstDirtyBlock > p->blockCount - 1) {
+        p->firstDirtyBlock = p->blockCount - 1;
+    }
+
+    memcpy(p->text + p->length, text, added + 1);
+    p->length += added;
+    if (!measureParagraphText(p, start)) {
+        fprintf(stderr, "ERROR: Failed to measure appended paragraph text\n");
+        return false;
+    }
+    return true;
+}
+
+// Replace the text of the paragraph, everything is measured and broken again. Returns false
+// like SParagraphAppend().
+bool SParagraphSetText(SParagraph* p, const char* text) {
+    if (!p) {
+        return false;
+    }
+    p->length = 0;
+    p->glyphCount = 0;
+    p->wordCount = 0;
+    p->lineCount = 0;
+    p->blockCount = 1;
+    memset(&p->blocks[0], 0, sizeof(SParaBlock));
+    p->blocks[0].dirty = true;
+    p->firstDirtyBlock = 0;
+    return text ? SParagraphAppend(p, text) : true;
+}
+
+void SParagraphSetMaxWidth(SParagraph* p, float maxWidth) {
+    if (p) p->maxWidth = maxWidth;
+}
+
+void SParagraphSetMaxHeight(SParagraph* p, float maxHeight) {
+    if (p) p->maxHeight = maxHeight;
+}
+
+void SParagraphSetAlign(SParagraph* p, STextAlign align) {
+    if (p) p->align = align;
+}
+
+void SParagraphSetWrap(SParagraph* p, STextWrap wrap) {
+    if (p && p->wrap != wrap) {
+        p->wrap = wrap;
+        p->relayout = true;
+    }
+}
+
+void SParagraphSetEllipsis(SParagraph* p, bool ellipsis) {
+    if (p) p->ellipsis = ellipsis;
+}
+
+// Greedy line breaking of one block from word fromWord on, which starts line fromLine. With
+// lines == NULL it only counts the lines, otherwise it fills lines from lines[0] (line fromLine)
+// and records the last line start on a word boundary as the block's resume point.
+static int breakParaBlock(SParagraph* p, SParaBlock* block, int fromWord, int fromLine, float width, SParaLine* lines) {
+    int count = 0;
+    int lineStart = fromWord < p->wordCount ? p->words[fromWord].firstGlyph : p->glyphCount;
+    float lineWidth = 0.0f;
+    float pending = 0.0f;
+    bool empty = true;
+    if (lines) {
+        block->resumeWord = fromWord;
+        block->resumeLine = fromLine;
+    }
+
+    for (int w = fromWord; w < block->firstWord + block->wordCount; w++) {
+        SParaWord* word = &p->words[w];
+
+        if (!empty && width > 0.0f && lineWidth + pending + word->width > width) {
+            if (lines) {
+                lines[count].firstGlyph = lineStart;
+                lines[count].glyphCount = word->firstGlyph - lineStart;
+                lines[count].width = lineWidth;
+                block->resumeWord = w;
+                block->resumeLine = fromLine + count + 1;
+            }
+            count++;
+            lineStart = word->firstGlyph;
+            lineWidth = 0.0f;
+            pending = 0.0f;
+            empty = true;
+        }
+
+        float x = empty ? 0.0f : lineWidth + pending;
+        for (int g = word->firstGlyph; g < word->firstGlyph + word->glyphCount; g++) {
+            SParaGlyph* glyph = &p->glyphs[g];
+            float gx = x + glyph->wordX;
+
+            // A word wider than the line is split between glyphs.
+            if (width > 0.0f && gx + glyph->advance > width && g > lineStart) {
+                if (lines) {
+                    lines[count].firstGlyph = lineStart;
+                    lines[count].glyphCount = g - lineStart;
+                    lines[count].width = x + p->glyphs[g - 1].wordX + p->glyphs[g - 1].advance;
+                }
+                count++;
+                lineStart = g;
+                x = -glyph->wordX;
+                gx = 0.0f;
+            }
+            if (lines) {
+                glyph->x = gx;
+            }
+        }
+        if (word->glyphCount > 0) {
+            lineWidth = x + word->width;
+            empty = false;
+        }
+        pending = word->spaceWidth;
+    }
+
+    if (lines) {
+        int end = block->firstWord + block->wordCount;
+        lines[count].firstGlyph = lineStart;
+        lines[count].glyphCount = (end < p->wordCount ? p->words[end].firstGlyph : p->glyphCount) - lineStart;
+        lines[count].width = lineWidth;
+    }
+    return count + 1;
+}
+
+// Break a block and replace its lines, later blocks only get their line index shifted.
+// resume keeps the lines before the block's resume point, greedy breaking of the words before
+// it does not change when words are appended.
+static bool layoutParaBlock(SParagraph* p, int index, bool resume) {
+    SParaBlock* block = &p->blocks[index];
+    float width = p->maxWidth;
+    bool balanced = width > 0.0f && block->naturalWidth > width && p->wrap == STEXT_WRAP_BALANCED;
+    int fromWord = block->firstWord, fromLine = 0;
+
+    if (balanced) {
+        // Find the narrowest width that still needs no more lines than greedy breaking.
+        int target = breakParaBlock(p, block, fromWord, 0, width, NULL);
+        float low = width / target, high = width;
+        for (int i = 0; i < 12 && target > 1; i++) {
+            float mid = (low + high) * 0.5f;
+            if (breakParaBlock(p, block, fromWord, 0, mid, NULL) <= target) {
+                high = mid;
+            } else {
+                low = mid;
+            }
+        }
+        width = high;
+    } else if (resume && block->lineCount > 0) {
+        fromWord = block->resumeWord;
+        fromLine = block->resumeLine;
+    }
+
+    int count = fromLine + breakParaBlock(p, block, fromWord, fromLine, width, NULL);
+    int delta = count - block->lineCount;
+    if (!reserveArray((void**)&p->lines, &p->lineCapacity, p->lineCount + delta, sizeof(SParaLine))) {
+        return false;
+    }
+
+    int after = block->firstLine + block->lineCount;
+    if (delta != 0) {
+        memmove(&p->lines[after + delta], &p->lines[after], (p->lineCount - after) * sizeof(SParaLine));
+        for (int i = index + 1; i < p->blockCount; i++) {
+            p->blocks[i].firstLine += delta;
+        }
+        p->lineCount += delta;
+    }
+    block->lineCount = count;
+    breakParaBlock(p, block, fromWord, fromLine, width, &p->lines[block->firstLine + fromLine]);
+    block->dirty = false;
+    block->appended = false;
+    return true;
+}
+
+// Bring naturalWidth up to date. Words before the last one are added once, the last one is
+// added on top each time since an append can still make it longer.
+static void measureParaBlock(SParagraph* p, SParaBlock* block) {
+    int last = block->wordCount - 1;
+    for (; block->measuredWords < last; block->measuredWords++) {
+        const SParaWord* word = &p->words[block->firstWord + block->measuredWords];
+        if (word->glyphCount > 0) {
+            block->measuredWidth += block->measuredSpace + word->width;
+            block->measuredSpace = 0.0f;
+        }
+        block->measuredSpace += word->spaceWidth;
+    }
+
+    block->naturalWidth = block->measuredWidth;
+    if (last >= 0 && p->words[block->firstWord + last].glyphCount > 0) {
+        block->naturalWidth += block->measuredSpace + p->words[block->firstWord + last].width;
+    }
+}
+
+// Bring the lines up to date with the text and the max width.
+void updateParagraphLayout(SParagraph* p) {
+    float oldWidth = p->layoutWidth;
+    float newWidth = p->maxWidth;
+    bool widthChanged = oldWidth != newWidth;
+
+    // Unless the width changed, only blocks from the first appended one on can need work.
+    int first = widthChanged || p->relayout ? 0 : p->firstDirtyBlock;
+    for (int i = first; i < p->blockCount; i++) {
+        SParaBlock* block = &p->blocks[i];
+
+        if (block->dirty) {
+            measureParaBlock(p, block);
+        }
+
+        // A block that fits on one line at both widths breaks the same way.
+        bool fitsOld = oldWidth <= 0.0f || block->naturalWidth <= oldWidth;
+        bool fitsNew = newWidth <= 0.0f || block->naturalWidth <= newWidth;
+        if (block->dirty || p->relayout || (widthChanged && !(fitsOld && fitsNew))) {
+            if (!layoutParaBlock(p, i, block->appended && !widthChanged && !p->relayout)) {
+                return;
+            }
+        }
+    }
+
+    p->layoutWidth = newWidth;
+    p->relayout = false;
+    p->firstDirtyBlock = p->blockCount;
+}
+
+// Number of lines that fit into maxHeight.
+static int visibleParagraphLines(const SParagraph* p, float lineHeight) {
+    if (p->maxHeight <= 0.0f) {
+        return p->lineCount;
+    }
+    int fit = (int)(p->maxHeight / lineHeight);
+    if (fit < 1) fit = 1;
+    return fit < p->lineCount ? fit : p->lineCount;
+}
+
+void SMeasureParagraph(SParagraph* p, float* width, float* height) {
+    float w = 0.0f, h = 0.0f;
+    if (p) {
+        updateParagraphLayout(p);
+        SFontSize* size = getFontSize(p->font, (float)p->pixelSize);
+        int visible = visibleParagraphLines(p, size->lineHeight);
+        for (int i = 0; i < visible; i++) {
+            if (p->lines[i].width > w) {
+                w = p->lines[i].width;
+            }
+        }
+        if (p->maxWidth > 0.0f && w > p->maxWidth) {
+            w = p->maxWidth;
+        }
+        h = visible * size->lineHeight;
+    }
+    if (width) *width = w;
+    if (height) *height = h;
+}
+
+#endif //LAYOUT_H
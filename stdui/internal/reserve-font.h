@@ -1,3 +1,7 @@
+#ifndef RESERVE_FONT_H
+#define RESERVE_FONT_H
+
+// 8x8 bitmap font for ASCII 32 to 122, one byte per row, most significant bit on the left.
 const unsigned char fontData[96][8] = {
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00}, // SPACE
     {0x18, 0x3C, 0x3C, 0x18, 0x18, 0x00, 0x18, 0x00}, // !
@@ -59,7 +63,7 @@ const unsigned char fontData[96][8] = {
     {0x66, 0x66, 0x66, 0x3C, 0x18, 0x18, 0x3C, 0x00}, // Y
     {0xFE, 0xC6, 0x8C, 0x18, 0x32, 0x66, 0xFE, 0x00}, // Z
     {0x3C, 0x30, 0x30, 0x30, 0x30, 0x30, 0x3C, 0x00}, // [
-    {0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x02, 0x00}, // \
+    {0xC0, 0x60, 0x30, 0x18, 0x0C, 0x06, 0x02, 0x00}, // BACKSLASH
     {0x3C, 0x0C, 0x0C, 0x0C, 0x0C, 0x0C, 0x3C, 0x00}, // ]
     {0x10, 0x38, 0x6C, 0xC6, 0x00, 0x00, 0x00, 0x00}, // ^
     {0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF}, // _
@@ -91,3 +95,5 @@ const unsigned char fontData[96][8] = {
     {0x00, 0x00, 0xC6, 0xC6, 0xC6, 0x7E, 0x06, 0xFC}, // y
     {0x00, 0x00, 0xFE, 0x8C, 0x18, 0x32, 0xFE, 0x00}  // z
 };
+
+#endif //RESERVE_FONT_H
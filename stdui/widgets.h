@@ -25,19 +25,40 @@ typedef struct {
 } SShapeProps;
 
 #if defined(GL_VERSION)
+#ifdef STDUI_GLES
+#include <GLES3/gl3.h>
+#else
 #include <GL/gl.h>
-#if defined(__linux__)
+#endif
+#if defined(__linux__) && (defined(STDUI_WAYLAND) || defined(STDUI_GLES))
+#include <EGL/egl.h>
+#elif defined(__linux__)
 #include <GL/glx.h>
 #include <X11/X.h>
 #include <X11/Xlib.h>
 #elif defined(_WIN32) || defined(_WIN64)
 #include <windows.h>
 #include <GL/gl.h>
+#include <GL/glext.h>
 #elif defined(__APPLE__)
 #include <OpenGL/gl.h>
 #include <OpenGL/CGLCurrent.h>
 #endif
 
+// Header of every stdui shader. GLSL ES has no default float precision in fragment shaders and
+// none for these sampler types in any stage.
+#ifdef STDUI_GLES
+#define STDUI_GLSL_VERSION \
+    "#version 300 es\n" \
+    "precision highp float;\n" \
+    "precision highp int;\n" \
+    "precision mediump sampler2DArray;\n" \
+    "precision highp usampler2D;\n"
+#else
+#define STDUI_GLSL_VERSION "#version 330 core\n"
+#endif
+
+#include "internal/gl_loader.h"
 
 typedef struct {
     // Programs and shaders
@@ -61,6 +82,9 @@ typedef struct {
 
 SRenderer renderer;
 
+// Set by image.h once it has GL objects of its own, SCleanupRenderer() frees them through it.
+static void (*cleanupImageRenderer)(void) = NULL;
+
 // Initialize the renderer
 bool SInitializeRenderer();
 
@@ -81,17 +105,25 @@ static inline SShapeProps SCreateShapeProps(float x, float y, float width, float
     return props;
 }
 
-// Swap buffers (platform-specific)
+// Swap buffers (platform-specific). SEndFrame() skips the swap of a frame drawn while the
+// window was hidden and paces the frames.
 static inline void SSwapBuffers(SApplication *app) {
-#if defined(__linux__)
-    glXSwapBuffers(app->display, app->window);
-#elif defined(_WIN32) || defined(_WIN64)
-    SwapBuffers(app->hdc);
+#if defined(__linux__) || defined(_WIN32) || defined(_WIN64)
+    SEndFrame(app);
 #elif defined(__APPLE__)
     CGLFlushDrawable(CGLGetCurrentContext());
 #endif
 }
 
+// SBeginFrame() found the window hidden, the draw functions do nothing until SEndFrame().
+static inline bool drawsDropped(SApplication *app) {
+#if defined(__linux__) || defined(_WIN32) || defined(_WIN64)
+    return app != NULL && app->frameHidden;
+#else
+    return false;
+#endif
+}
+
 // Drawing functions
 void STriangle(SApplication *app, const SShapeProps *props);
 void SRectangle(SApplication *app, const SShapeProps *props);
@@ -225,11 +257,65 @@ void setOrthographicProjection(GLuint programID, int width, int height) {
 }
 
 
+// A VAO with one vec3 position attribute over a shared vertex buffer.
+static GLuint createShapeVAO(GLuint vertexBuffer, GLuint indexBuffer) {
+    GLuint vao;
+    glGenVertexArrays(1, &vao);
+    glBindVertexArray(vao);
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+    if (indexBuffer) {
+        glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+    }
+    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(0);
+
+    glBindVertexArray(0);
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return vao;
+}
+
+// VAOs are not shared between GL contexts, every context builds its own over the shared buffers.
+static void createShapeVAOs(void) {
+    renderer.rectVAO = createShapeVAO(renderer.rectVBO, renderer.rectEBO);
+    renderer.triangleVAO = createShapeVAO(renderer.triangleVBO, 0);
+    renderer.circleVAO = createShapeVAO(renderer.circleVBO, renderer.circleEBO);
+}
+
 // Implementation of the renderer initialization
+#ifdef STDUI_VERBAL_DEBUG
+static void STDUI_GLAPI printGLDebugMessage(GLenum source, GLenum type, GLuint id, GLenum severity,
+                                            GLsizei length, const GLchar* message, const void* user) {
+    (void)source; (void)type; (void)id; (void)length; (void)user;
+    if (severity != GL_DEBUG_SEVERITY_NOTIFICATION) {
+        fprintf(stderr, "OpenGL debug message: %s\n", message);
+    }
+}
+#endif
+
+// Programs and buffers are created once and shared by every window, later calls from another
+// context in the share group only build that context's VAOs.
 bool SInitializeRenderer() {
+    if (!SLoadGL()) {
+        return false;
+    }
+
+    #ifdef STDUI_VERBAL_DEBUG
+    // Debug output is per context, every window reports its own errors.
+    if (stduiGL.debugOutput) {
+        glEnable(GL_DEBUG_OUTPUT);
+        stduiGL.DebugMessageCallback(printGLDebugMessage, NULL);
+    }
+    #endif
+
+    if (renderer.basicProgram != 0) {
+        createShapeVAOs();
+        return true;
+    }
+
     // Basic shader for shapes
     const char* vertexShaderSource = 
-        "#version 330 core\n"
+        STDUI_GLSL_VERSION
         "layout (location = 0) in vec3 aPos;\n"
         "uniform mat4 model;\n"
         "uniform mat4 projection;\n"
@@ -239,7 +325,7 @@ bool SInitializeRenderer() {
         "}\0";
     
     const char* fragmentShaderSource = 
-        "#version 330 core\n"
+        STDUI_GLSL_VERSION
         "out vec4 FragColor;\n"
         "uniform vec4 color;\n"
         "void main()\n"
@@ -268,20 +354,15 @@ bool SInitializeRenderer() {
         2, 3, 0   // second triangle
     };
     
-    glGenVertexArrays(1, &renderer.rectVAO);
+    // Index data goes in through GL_ARRAY_BUFFER, binding an element buffer needs a VAO.
     glGenBuffers(1, &renderer.rectVBO);
     glGenBuffers(1, &renderer.rectEBO);
-    
-    glBindVertexArray(renderer.rectVAO);
-    
+
     glBindBuffer(GL_ARRAY_BUFFER, renderer.rectVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(rectangleVertices), rectangleVertices, GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.rectEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(rectangleIndices), rectangleIndices, GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.rectEBO);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(rectangleIndices), rectangleIndices, GL_STATIC_DRAW);
     
     // Create triangle mesh
     float triangleVertices[] = {
@@ -290,17 +371,11 @@ bool SInitializeRenderer() {
          0.0f,  0.5f, 0.0f   // top
     };
     
-    glGenVertexArrays(1, &renderer.triangleVAO);
     glGenBuffers(1, &renderer.triangleVBO);
-    
-    glBindVertexArray(renderer.triangleVAO);
-    
+
     glBindBuffer(GL_ARRAY_BUFFER, renderer.triangleVBO);
     glBufferData(GL_ARRAY_BUFFER, sizeof(triangleVertices), triangleVertices, GL_STATIC_DRAW);
     
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
     // Create circle mesh
     const int segments = 36;
     const float angleIncrement = 2.0f * M_PI / segments;
@@ -329,36 +404,32 @@ bool SInitializeRenderer() {
         }
     }
     
-    glGenVertexArrays(1, &renderer.circleVAO);
     glGenBuffers(1, &renderer.circleVBO);
     glGenBuffers(1, &renderer.circleEBO);
-    
-    glBindVertexArray(renderer.circleVAO);
-    
+
     glBindBuffer(GL_ARRAY_BUFFER, renderer.circleVBO);
     glBufferData(GL_ARRAY_BUFFER, (segments + 2) * 3 * sizeof(float), circleVertices, GL_STATIC_DRAW);
-    
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, renderer.circleEBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, segments * 3 * sizeof(unsigned int), circleIndices, GL_STATIC_DRAW);
-    
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
-    glEnableVertexAttribArray(0);
-    
+
+    glBindBuffer(GL_ARRAY_BUFFER, renderer.circleEBO);
+    glBufferData(GL_ARRAY_BUFFER, segments * 3 * sizeof(unsigned int), circleIndices, GL_STATIC_DRAW);
+
     // Cleanup
     free(circleVertices);
     free(circleIndices);
-    
+
     // Unbind
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    createShapeVAOs();
 
-    glEnable(GL_DEBUG_OUTPUT);
-    
     return true;
 }
 
 // Implementation of drawing functions
 void STriangle(SApplication *app, const SShapeProps *props) {
+    if (drawsDropped(app)) {
+        return;
+    }
+
     // Create model matrix
     float modelMatrix[16];
     createTransformMatrix(modelMatrix, props->x, props->y, props->width, props->height, props->rotation);
@@ -380,6 +451,10 @@ void STriangle(SApplication *app, const SShapeProps *props) {
 }
 
 void SRectangle(SApplication *app, const SShapeProps *props) {
+    if (drawsDropped(app)) {
+        return;
+    }
+
     // Create model matrix
     float modelMatrix[16];
     createTransformMatrix(modelMatrix, props->x, props->y, props->width, props->height, props->rotation);
@@ -400,6 +475,10 @@ void SRectangle(SApplication *app, const SShapeProps *props) {
 }
 
 void SCircle(SApplication *app, const SShapeProps *props) {
+    if (drawsDropped(app)) {
+        return;
+    }
+
     // Create model matrix
     float modelMatrix[16];
     createTransformMatrix(modelMatrix, props->x, props->y, props->width, props->height, props->rotation);
@@ -421,6 +500,9 @@ void SCircle(SApplication *app, const SShapeProps *props) {
 }
 
 void SPolygon(SApplication *app, const SShapeProps *props, const float *vertices, int vertexCount) {
+    if (drawsDropped(app)) {
+        return;
+    }
     if (vertexCount < 3 || vertices == NULL) {
         fprintf(stderr, "Error: Invalid polygon data\n");
         return;
@@ -482,6 +564,10 @@ void SDrawCircle(SApplication *app, float color[3], float posX, float posY, floa
 
 // Clean up renderer resources
 void SCleanupRenderer() {
+    if (renderer.basicProgram == 0) {
+        return;
+    }
+
     // Delete shader programs
     glDeleteProgram(renderer.basicProgram);
     
@@ -496,6 +582,13 @@ void SCleanupRenderer() {
     glDeleteVertexArrays(1, &renderer.circleVAO);
     glDeleteBuffers(1, &renderer.circleVBO);
     glDeleteBuffers(1, &renderer.circleEBO);
+
+    if (cleanupImageRenderer) {
+        cleanupImageRenderer();
+    }
+
+    memset(&renderer, 0, sizeof(renderer));
+    stduiGL.loaded = false; // The next first context may be from another driver.
 }
 
 
@@ -583,24 +676,39 @@ void SCircle(SApplication *app, const SShapeProps *props) {
 //GLOBAL stuff that dosen't care about version.
 
 
-void checkGLSLVersion() { //Easy stuff to prevent a random error.
+// Desktop GL needs GLSL 3.30, GLES builds need GLSL ES 3.00. GLES drivers report the version
+// as "OpenGL ES GLSL ES 3.00 ...", so parsing starts at the first digit.
+bool checkGLSLVersion() { //Easy stuff to prevent a random error.
     const GLubyte* versionStr = glGetString(GL_SHADING_LANGUAGE_VERSION);
     if (versionStr == NULL) {
         fprintf(stderr, "ERROR: Unable to retrieve GLSL version.\n");
-        exit(EXIT_FAILURE);
+        return false;
+    }
+
+    const char* digits = (const char*)versionStr;
+    while (*digits && (*digits < '0' || *digits > '9')) {
+        digits++;
     }
 
     int major = 0, minor = 0;
-    if (sscanf((const char*)versionStr, "%d.%d", &major, &minor) != 2) {
+    if (sscanf(digits, "%d.%d", &major, &minor) != 2) {
         fprintf(stderr, "ERROR: Unable to parse GLSL version.\n");
-        exit(EXIT_FAILURE);
+        return false;
     }
 
+#ifdef STDUI_GLES
+    if (major < 3) {
+        fprintf(stderr, "ERROR: GLSL ES version 3.0 is required. Detected version: %d.%d\n", major, minor);
+        return false;
+    }
+#else
     // Check if version < 3.3
     if (major < 3 || (major == 3 && minor < 3)) {
         fprintf(stderr, "ERROR: GLSL version 3.3 is required. Detected version: %d.%d\n", major, minor);
-        exit(EXIT_FAILURE);
+        return false;
     }
+#endif
+    return true;
 }
 void SGL_Error(const char* operation) {
     GLenum error;
@@ -611,125 +719,190 @@ void SGL_Error(const char* operation) {
 
 
 // Global variables for text rendering
-GLuint fontTexture;
+GLuint fontTexture; // Texture array, one layer per glyph atlas page.
+int fontTextureLayers = 0;
 GLuint textVAO, textVBO;
 GLuint textShader;
-stbtt_bakedchar charData[96]; // ASCII 32..126 is 95 glyphs
-float fontTexWidth = 512;
-float fontTexHeight = 512;
+GLuint textSDFShader;
+GLuint textGridShader;
+GLuint textBlobVAO, textBlobVBO; // Instances of every STextBlob, see allocateBlobRange().
+GLuint textBlobShader, textBlobSDFShader;
+
+typedef struct {
+    int first, count;
+} STextBlobRange;
 
-// Generate font texture using stb_truetype
+static int textBlobCapacity = 0, textBlobEnd = 0; // In instances.
+static STextBlobRange* textBlobFree = NULL;     // Free ranges below textBlobEnd, sorted.
+static int textBlobFreeCount = 0, textBlobFreeCapacity = 0;
+SGlyphCache glyphCache;
+
+#define STDUI_TEXT_BATCH 512 // Glyphs per draw call.
+
+static float textVertices[STDUI_TEXT_BATCH * 6 * 5];
+
+// With buffer storage textVBO holds STDUI_TEXT_RING batches and stays mapped, batches are
+// written in place instead of orphaning the buffer on every flush. A fence per batch keeps the
+// CPU from overwriting one the GPU still reads.
+#ifndef STDUI_TEXT_RING
+#define STDUI_TEXT_RING 8
+#endif
+static float* textRing = NULL;
+static GLsync textRingFences[STDUI_TEXT_RING];
+static int textRingNext = 0;
+
+// Create the glyph atlas texture and load the default font.
+// fontPath may be NULL, the built in default font is used then or if the file fails to load.
 bool generateFontTexture(const char* fontPath) {
-    // Load font file
-    FILE* fontFile = fopen(fontPath, "rb");
-    if (!fontFile) {
-        fprintf(stderr, "ERROR: Failed to open font file: %s\n", fontPath);
-        return false;
-    }
-    
-    // Get file size
-    fseek(fontFile, 0, SEEK_END);
-    long fileSize = ftell(fontFile);
-    fseek(fontFile, 0, SEEK_SET);
-    
-    // Read font file data
-    unsigned char* fontFileData = (unsigned char*)malloc(fileSize);
-    if (!fontFileData) {
-        fprintf(stderr, "ERROR: Failed to allocate memory for font file\n");
-        fclose(fontFile);
-        return false;
-    }
-    
-    fread(fontFileData, 1, fileSize, fontFile);
-    fclose(fontFile);
-    
-    // Create bitmap for font texture atlas
-    unsigned char* bitmapData = (unsigned char*)malloc(fontTexWidth * fontTexHeight);
-    if (!bitmapData) {
-        fprintf(stderr, "ERROR: Failed to allocate memory for font bitmap\n");
-        free(fontFileData);
-        return false;
+    SFont* font = fontPath ? SLoadFont(fontPath) : NULL;
+    if (!font) {
+        font = SLoadDefaultFont();
+        if (!font) {
+            return false;
+        }
     }
-    
-    // Bake font to bitmap
-    // Parameters: font data, font index, font height in pixels, bitmap data, width, height, first char, num chars, output char data
-    int result = stbtt_BakeFontBitmap(fontFileData, 0, 24.0f, bitmapData, fontTexWidth, fontTexHeight, 32, 96, charData);
-    
-    if (result <= 0) {
-        fprintf(stderr, "ERROR: Failed to bake font bitmap\n");
-        free(fontFileData);
-        free(bitmapData);
+
+    if (!initGlyphCache(&glyphCache)) {
         return false;
     }
-    
-    // Generate OpenGL texture
+    currentFont = font;
+
+    // Generate OpenGL texture, layers are allocated once the first glyph is uploaded.
     glGenTextures(1, &fontTexture);
-    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, fontTexture);
     
     // Set texture parameters
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    
-    // Upload texture
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RED, fontTexWidth, fontTexHeight, 0, GL_RED, GL_UNSIGNED_BYTE, bitmapData);
-    
-    // Clean up
-    free(fontFileData);
-    free(bitmapData);
-    
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    fontTextureLayers = 0;
+
     return true;
 }
 
+// Upload glyphs rasterized since the last upload, only the dirty part of each page is sent.
+void uploadGlyphAtlas() {
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, STDUI_ATLAS_PAGE_SIZE);
+
+    // A new page was added, reallocate the array and send every page again.
+    if (glyphCache.pageCount > fontTextureLayers) {
+        glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, STDUI_ATLAS_PAGE_SIZE, STDUI_ATLAS_PAGE_SIZE,
+                     glyphCache.pageCount, 0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+        fontTextureLayers = glyphCache.pageCount;
+        for (int i = 0; i < glyphCache.pageCount; i++) {
+            markPageDirty(&glyphCache.pages[i], 0, 0, STDUI_ATLAS_PAGE_SIZE, STDUI_ATLAS_PAGE_SIZE);
+        }
+    }
+
+    for (int i = 0; i < glyphCache.pageCount; i++) {
+        SAtlasPage* page = &glyphCache.pages[i];
+        if (page->dirtyX1 <= page->dirtyX0 || page->dirtyY1 <= page->dirtyY0) {
+            continue;
+        }
+
+        glPixelStorei(GL_UNPACK_SKIP_PIXELS, page->dirtyX0);
+        glPixelStorei(GL_UNPACK_SKIP_ROWS, page->dirtyY0);
+        glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, page->dirtyX0, page->dirtyY0, i,
+                        page->dirtyX1 - page->dirtyX0, page->dirtyY1 - page->dirtyY0, 1,
+                        GL_RED, GL_UNSIGNED_BYTE, page->pixels);
+        page->dirtyX0 = page->dirtyY0 = page->dirtyX1 = page->dirtyY1 = 0;
+    }
+
+    glPixelStorei(GL_UNPACK_SKIP_PIXELS, 0);
+    glPixelStorei(GL_UNPACK_SKIP_ROWS, 0);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+// The text VAOs of the current context. The blob VAO gets its attribute pointers at draw time.
+static void createTextVAOs(void) {
+    glGenVertexArrays(1, &textVAO);
+    glBindVertexArray(textVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+
+    // Setup vertex attributes (x, y, u, v, atlas page)
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 5 * sizeof(float), 0);
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 5 * sizeof(float), (void*)(2 * sizeof(float)));
+
+    glGenVertexArrays(1, &textBlobVAO);
+    glBindVertexArray(textBlobVAO);
+    for (int i = 0; i < 3; i++) {
+        glEnableVertexAttribArray(i);
+        glVertexAttribDivisor(i, 1);
+    }
+
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    glBindVertexArray(0);
+}
+
+// The atlas, buffers and programs are created by the first call and shared by every window,
+// later calls from another context in the share group only build that context's VAOs.
 bool initText(const char* fontPath) {
 
-    checkGLSLVersion();
+    if (!checkGLSLVersion()) {
+        return false;
+    }
 
     // Save previous OpenGL state
     GLint prevVAO, prevArrayBuffer, prevProgram;
     glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
     glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevArrayBuffer);
     glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
-    
+
+    if (textShader != 0) {
+        createTextVAOs();
+        glBindVertexArray(prevVAO);
+        glBindBuffer(GL_ARRAY_BUFFER, prevArrayBuffer);
+        return true;
+    }
+
     // Generate font texture
     if (!generateFontTexture(fontPath)) {
         fprintf(stderr, "ERROR: Failed to generate font texture\n");
         return false;
     }
-    
-    // Create VBO and VAO for text rendering
-    glGenVertexArrays(1, &textVAO);
+
+    // Create the VBO for text rendering, the mapped ring or pre-allocated for one batch.
     glGenBuffers(1, &textVBO);
-    glBindVertexArray(textVAO);
     glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-    
-    // Pre-allocate buffer data
-    glBufferData(GL_ARRAY_BUFFER, sizeof(float) * 6 * 4, NULL, GL_DYNAMIC_DRAW);
-    
-    // Setup vertex attributes
-    glEnableVertexAttribArray(0);
-    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 4 * sizeof(float), 0);
-    
+    if (stduiGL.bufferStorage) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        stduiGL.BufferStorage(GL_ARRAY_BUFFER, sizeof(textVertices) * STDUI_TEXT_RING, NULL, flags);
+        textRing = (float*)glMapBufferRange(GL_ARRAY_BUFFER, 0, sizeof(textVertices) * STDUI_TEXT_RING, flags);
+        if (textRing == NULL) {
+            // Immutable storage can not be reallocated, start over with a plain buffer.
+            glDeleteBuffers(1, &textVBO);
+            glGenBuffers(1, &textVBO);
+            glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+        }
+    }
+    if (textRing == NULL) {
+        glBufferData(GL_ARRAY_BUFFER, sizeof(textVertices), NULL, GL_DYNAMIC_DRAW);
+    }
     glBindBuffer(GL_ARRAY_BUFFER, 0);
-    glBindVertexArray(0);
+    createTextVAOs();
     
     // Create shader program
     const char* vertexSource = 
-        "#version 330 core\n"
-        "layout (location = 0) in vec4 vertex;\n"
-        "out vec2 TexCoords;\n"
+        STDUI_GLSL_VERSION
+        "layout (location = 0) in vec2 position;\n"
+        "layout (location = 1) in vec3 texCoords;\n"
+        "out vec3 TexCoords;\n"
         "uniform mat4 projection;\n"
         "void main() {\n"
-        "   gl_Position = projection * vec4(vertex.xy, 0.0, 1.0);\n"
-        "   TexCoords = vertex.zw;\n"
+        "   gl_Position = projection * vec4(position, 0.0, 1.0);\n"
+        "   TexCoords = texCoords;\n"
         "}\0";
     
     const char* fragmentSource = 
-        "#version 330 core\n"
-        "in vec2 TexCoords;\n"
+        STDUI_GLSL_VERSION
+        "in vec3 TexCoords;\n"
         "out vec4 color;\n"
-        "uniform sampler2D text;\n"
+        "uniform sampler2DArray text;\n"
         "uniform vec3 textColor;\n"
         "void main() {\n"
         "   float alpha = texture(text, TexCoords).r;\n"
@@ -778,6 +951,85 @@ bool initText(const char* fontPath) {
     // Clean up shaders
     glDeleteShader(vertex);
     glDeleteShader(fragment);
+
+    // Distance field variant, used for fonts set to STEXT_SDF.
+    // The edge is at STDUI_SDF_ONEDGE, fwidth keeps the edge about one pixel wide at any scale.
+    const char* sdfFragmentSource = 
+        STDUI_GLSL_VERSION
+        "in vec3 TexCoords;\n"
+        "out vec4 color;\n"
+        "uniform sampler2DArray text;\n"
+        "uniform vec3 textColor;\n"
+        "void main() {\n"
+        "   float dist = texture(text, TexCoords).r;\n"
+        "   float width = max(fwidth(dist), 1.0 / 255.0);\n"
+        "   float alpha = smoothstep(0.502 - width, 0.502 + width, dist);\n"
+        "   color = vec4(textColor, alpha);\n"
+        "}\0";
+    textSDFShader = createShaderProgram(vertexSource, sdfFragmentSource);
+
+    // Text grids, one quad covers the grid and every pixel looks up its cell, see STextGrid.
+    const char* gridVertexSource =
+        STDUI_GLSL_VERSION
+        "out vec2 local;\n"
+        "uniform mat4 projection;\n"
+        "uniform vec2 origin;\n"
+        "uniform vec2 size;\n"
+        "void main() {\n"
+        "   local = vec2(gl_VertexID & 1, gl_VertexID >> 1) * size;\n"
+        "   gl_Position = projection * vec4(origin + local, 0.0, 1.0);\n"
+        "}\0";
+
+    const char* gridFragmentSource =
+        STDUI_GLSL_VERSION
+        "in vec2 local;\n"
+        "out vec4 color;\n"
+        "uniform usampler2D cells;\n"
+        "uniform sampler2DArray text;\n"
+        "uniform ivec2 cellSize;\n"
+        "uniform int rows;\n"
+        "uniform int scroll;\n"
+        "uniform int baseline;\n"
+        "vec4 unpackColor(uint c) {\n"
+        "   return vec4((uvec4(c) >> uvec4(0u, 8u, 16u, 24u)) & 0xFFu) / 255.0;\n"
+        "}\n"
+        "void main() {\n"
+        "   ivec2 pixel = ivec2(floor(local));\n"
+        "   ivec2 cell = pixel / cellSize;\n"
+        "   ivec2 inCell = pixel - cell * cellSize;\n"
+        "   uvec4 data = texelFetch(cells, ivec2(cell.x, (cell.y + scroll) % rows), 0);\n"
+        "   vec4 fg = unpackColor(data.z);\n"
+        "   vec4 bg = unpackColor(data.w);\n"
+        "   ivec2 atlas = ivec2(data.x & 0xFFFu, (data.x >> 12) & 0xFFFu);\n"
+        "   ivec2 box = ivec2(data.y & 0xFFu, (data.y >> 8) & 0xFFu);\n"
+        "   ivec2 offset = ivec2((data.y >> 16) & 0xFFu, data.y >> 24) - 128;\n"
+        "   ivec2 p = inCell - ivec2(offset.x, baseline + offset.y);\n"
+        "   float alpha = 0.0;\n"
+        "   if (all(greaterThanEqual(p, ivec2(0))) && all(lessThan(p, box))) {\n"
+        "       alpha = texelFetch(text, ivec3(atlas + p, int(data.x >> 24)), 0).r * fg.a;\n"
+        "   }\n"
+        "   float a = alpha + bg.a * (1.0 - alpha);\n"
+        "   vec3 rgb = fg.rgb * alpha + bg.rgb * bg.a * (1.0 - alpha);\n"
+        "   color = vec4(rgb / max(a, 1e-5), a);\n"
+        "}\0";
+    textGridShader = createShaderProgram(gridVertexSource, gridFragmentSource);
+
+    // Text blobs, one instance per glyph, the quad corners come from gl_VertexID.
+    const char* blobVertexSource =
+        STDUI_GLSL_VERSION
+        "layout (location = 0) in vec4 rect;\n"
+        "layout (location = 1) in vec4 texRect;\n"
+        "layout (location = 2) in float page;\n"
+        "out vec3 TexCoords;\n"
+        "uniform mat4 projection;\n"
+        "uniform vec2 origin;\n"
+        "void main() {\n"
+        "   vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+        "   gl_Position = projection * vec4(origin + mix(rect.xy, rect.zw, corner), 0.0, 1.0);\n"
+        "   TexCoords = vec3(mix(texRect.xy, texRect.zw, corner), page);\n"
+        "}\0";
+    textBlobShader = createShaderProgram(blobVertexSource, fragmentSource);
+    textBlobSDFShader = createShaderProgram(blobVertexSource, sdfFragmentSource);
     
     // Restore previous OpenGL state
     glBindVertexArray(prevVAO);
@@ -792,29 +1044,153 @@ bool initText(const char* fontPath) {
 }
 
 void SCleanupTextRenderer() {
+    if (textShader == 0) {
+        return;
+    }
+
     // Clean up text rendering resources
+    stopGlyphWorkers(&glyphCache);
     glDeleteTextures(1, &fontTexture);
     glDeleteVertexArrays(1, &textVAO);
-    glDeleteBuffers(1, &textVBO);
+    glDeleteBuffers(1, &textVBO); // Also unmaps the ring.
+    for (int i = 0; i < STDUI_TEXT_RING; i++) {
+        if (textRingFences[i]) {
+            glDeleteSync(textRingFences[i]);
+            textRingFences[i] = NULL;
+        }
+    }
+    textRing = NULL;
+    textRingNext = 0;
     glDeleteProgram(textShader);
+    glDeleteProgram(textSDFShader);
+    glDeleteProgram(textGridShader);
+    glDeleteProgram(textBlobShader);
+    glDeleteProgram(textBlobSDFShader);
+    glDeleteVertexArrays(1, &textBlobVAO);
+    glDeleteBuffers(1, &textBlobVBO);
+    textBlobVBO = 0;
+    textBlobCapacity = textBlobEnd = textBlobFreeCount = 0;
+    destroyGlyphCache(&glyphCache);
+    clearTextRunCache();
+    fontTextureLayers = 0;
+    fontTexture = textVAO = textVBO = textBlobVAO = 0;
+    textShader = textSDFShader = textGridShader = textBlobShader = textBlobSDFShader = 0;
 }
 
+// Per context objects of the current context, see SContextObjects in window.h.
+void SGetContextObjects(SContextObjects* objects) {
+    objects->rectVAO = renderer.rectVAO;
+    objects->triangleVAO = renderer.triangleVAO;
+    objects->circleVAO = renderer.circleVAO;
+    objects->textVAO = textVAO;
+    objects->textBlobVAO = textBlobVAO;
+}
 
-void SDrawText(SApplication *app, const char* text, float x, float y, float scale, float r, float g, float b) {
+// Point the draw functions at another context's objects after switching contexts.
+void SUseContextObjects(const SContextObjects* objects) {
+    renderer.rectVAO = objects->rectVAO;
+    renderer.triangleVAO = objects->triangleVAO;
+    renderer.circleVAO = objects->circleVAO;
+    textVAO = objects->textVAO;
+    textBlobVAO = objects->textBlobVAO;
+}
+
+// Delete the objects of a context that is about to go away, it must be current.
+void SDeleteContextObjects(SContextObjects* objects) {
+    GLuint vaos[5] = { objects->rectVAO, objects->triangleVAO, objects->circleVAO,
+                       objects->textVAO, objects->textBlobVAO };
+    glDeleteVertexArrays(5, vaos);
+    memset(objects, 0, sizeof(*objects));
+}
+
+// Choose what a draw does with glyphs that are not rasterized yet, see SGlyphLoadMode.
+// workerCount <= 0 picks one worker per spare core. Returns false if no worker could be started.
+bool SSetGlyphLoading(SGlyphLoadMode mode, int workerCount) {
+    stopGlyphWorkers(&glyphCache);
+    if (mode == SGLYPH_LOAD_BLOCK) {
+        return true;
+    }
+    return startGlyphWorkers(mode, workerCount);
+}
+
+// Use a font loaded with SLoadFont() for the following SDrawText calls.
+void SSetFont(SFont* font) {
+    if (font) {
+        currentFont = font;
+    }
+}
+
+// OpenGL state saved while text is drawn.
+typedef struct {
+    GLint program, texture, vao, buffer;
+    GLboolean blend;
+    GLint blendSrc, blendDst;
+} STextGLState;
+
+static int textBatchCount = 0;
+
+// Draw the batched glyph quads.
+static void flushTextBatch() {
+    if (textBatchCount == 0) {
+        return;
+    }
+
+    uploadGlyphAtlas();
+
+    if (textRing) {
+        // The batch written STDUI_TEXT_RING flushes ago is almost always drawn by now.
+        GLsync fence = textRingFences[textRingNext];
+        if (fence) {
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000); // 1 s
+            glDeleteSync(fence);
+        }
+        int first = textRingNext * STDUI_TEXT_BATCH * 6;
+        memcpy(textRing + first * 5, textVertices, textBatchCount * 6 * 5 * sizeof(float));
+        glDrawArrays(GL_TRIANGLES, first, textBatchCount * 6);
+        textRingFences[textRingNext] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        textRingNext = (textRingNext + 1) % STDUI_TEXT_RING;
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
+        glBufferData(GL_ARRAY_BUFFER, sizeof(textVertices), NULL, GL_DYNAMIC_DRAW); // Orphan the old storage.
+        glBufferSubData(GL_ARRAY_BUFFER, 0, textBatchCount * 6 * 5 * sizeof(float), textVertices);
+        glDrawArrays(GL_TRIANGLES, 0, textBatchCount * 6);
+    }
+    textBatchCount = 0;
+}
+
+static SApplication* glyphWakeApp = NULL; // Window the glyph workers wake, see setGlyphWake().
+
+static void wakeForGlyphs(void* app) {
+    SPostEmptyEvent((SApplication*)app);
+}
+
+// Have the workers wake app once the glyphs it queues are done, so SWaitEvents(app, -1) redraws.
+static void watchGlyphJobs(SApplication* app) {
+    if (app != glyphWakeApp) {
+        glyphWakeApp = app;
+        setGlyphWake(wakeForGlyphs, app);
+    }
+}
+
+// Called by SDisplayClose(), the workers must not wake a window that is gone.
+void releaseGlyphWake(SApplication *app) {
+    if (app == glyphWakeApp) {
+        glyphWakeApp = NULL;
+        setGlyphWake(NULL, NULL);
+    }
+}
+
+static void beginTextDraw(SApplication *app, STextMode mode, float r, float g, float b, STextGLState* saved) {
     // Save current OpenGL state
-    GLint prevProgram, prevTexture, prevVAO, prevBuffer;
-    GLboolean prevBlendEnabled;
-    GLint prevBlendSrc, prevBlendDst;
-    
-    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
-    glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTexture);
-    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
-    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+    glGetIntegerv(GL_CURRENT_PROGRAM, &saved->program);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &saved->texture);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &saved->vao);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &saved->buffer);
     
     // Save blend state
-    prevBlendEnabled = glIsEnabled(GL_BLEND);
-    glGetIntegerv(GL_BLEND_SRC_ALPHA, &prevBlendSrc);
-    glGetIntegerv(GL_BLEND_DST_ALPHA, &prevBlendDst);
+    saved->blend = glIsEnabled(GL_BLEND);
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &saved->blendSrc);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &saved->blendDst);
     
     // Enable blending for text
     glEnable(GL_BLEND);
@@ -831,77 +1207,874 @@ void SDrawText(SApplication *app, const char* text, float x, float y, float scal
         0.0f, 0.0f, -1.0f, 0.0f,
         -1.0f, 1.0f, 0.0f, 1.0f
     };
-    glUniformMatrix4fv(glGetUniformLocation(textShader, "projection"), 1, GL_FALSE, projection);
+    GLuint program = mode == STEXT_SDF ? textSDFShader : textShader;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, projection);
+    glUniform3f(glGetUniformLocation(program, "textColor"), r, g, b);
+    glUniform1i(glGetUniformLocation(program, "text"), 0);
     
     // Activate texture
     glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_2D, fontTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, fontTexture);
     
     // Bind VAO
     glBindVertexArray(textVAO);
+
+    glyphCache.tick++;
+    textBatchCount = 0;
+
+    // Glyphs finished by the workers go out with this draw's atlas upload.
+    watchGlyphJobs(app);
+    collectGlyphJobs(&glyphCache, false);
+}
+
+// Queue the quad of a glyph whose pen position is (penX, baseline).
+static void pushGlyphQuad(const SGlyph* glyph, float penX, float baseline, float glyphScale) {
+    if (glyph->page < 0) {
+        return;
+    }
+
+    const float texel = 1.0f / STDUI_ATLAS_PAGE_SIZE;
+    float x0 = penX + glyph->xoff * glyphScale;
+    float y0 = baseline + glyph->yoff * glyphScale;
+    if (glyphScale == 1.0f) {
+        x0 = roundf(x0); // Keep bitmap glyphs on the pixel grid.
+    }
+    float x1 = x0 + glyph->w * glyphScale;
+    float y1 = y0 + glyph->h * glyphScale;
+    float s0 = glyph->x * texel, t0 = glyph->y * texel;
+    float s1 = (glyph->x + glyph->w) * texel, t1 = (glyph->y + glyph->h) * texel;
+    float layer = (float)glyph->page;
+
+    // Create vertices for this character
+    float vertices[6][5] = {
+        { x0, y0, s0, t0, layer },
+        { x0, y1, s0, t1, layer },
+        { x1, y1, s1, t1, layer },
+
+        { x0, y0, s0, t0, layer },
+        { x1, y1, s1, t1, layer },
+        { x1, y0, s1, t0, layer }
+    };
+    memcpy(&textVertices[textBatchCount * 6 * 5], vertices, sizeof(vertices));
+
+    if (++textBatchCount == STDUI_TEXT_BATCH) {
+        flushTextBatch();
+    }
+}
+
+static void endTextDraw(const STextGLState* saved) {
+    flushTextBatch();
+
+    // Restore previous OpenGL state
+    glBindVertexArray(saved->vao);
+    glBindBuffer(GL_ARRAY_BUFFER, saved->buffer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, saved->texture);
+    glUseProgram(saved->program);
     
-    // Starting position
-    float startX = x;
-    float startY = y;
-    
-    // Render each character
-    while (*text) {
-        char c = *text++;
-        
-        // Handle newlines
-        if (c == '\n') {
-            y += (charData[0].y1 - charData[0].y0) * 1.25f * scale;
-            x = startX;
-            continue;
+    // Restore blend state
+    if (!saved->blend)
+        glDisable(GL_BLEND);
+    glBlendFunc(saved->blendSrc, saved->blendDst);
+}
+
+// Bitmap glyphs are rasterized at the size they are drawn at, scale 1 is the default 24px.
+// Distance field glyphs always come from the STDUI_SDF_SIZE entry and are scaled by glyphScale.
+static SFontSize* getGlyphFontSize(SFont* font, float pixelSize, float* glyphScale) {
+    if (font->mode == STEXT_SDF) {
+        SFontSize* size = getFontSize(font, STDUI_SDF_SIZE);
+        *glyphScale = pixelSize / size->pixelSize;
+        return size;
+    }
+    *glyphScale = 1.0f;
+    return getFontSize(font, pixelSize);
+}
+
+// Measure the size text would take when drawn, wrapWidth <= 0 disables wrapping.
+void SMeasureText(const char* text, float scale, float wrapWidth, float* width, float* height) {
+    float w = 0.0f, h = 0.0f;
+    if (text != NULL && currentFont != NULL) {
+        float glyphScale;
+        SFontSize* size = getGlyphFontSize(currentFont, STDUI_DEFAULT_FONT_SIZE * scale, &glyphScale);
+        STextKey key = SMakeTextKey(text, -1);
+        const STextRun* run = getTextRun(size, &key, wrapWidth > 0.0f ? wrapWidth / glyphScale : 0.0f);
+        if (run) {
+            w = run->width * glyphScale;
+            h = run->height * glyphScale;
         }
-        
-        // Skip non-printable characters
-        if (c < 32 || c > 127) {
+    }
+    if (width) *width = w;
+    if (height) *height = h;
+}
+
+// Draw text from SMakeTextKey(), the string is neither measured nor hashed again.
+void SDrawTextKeyed(SApplication *app, const STextKey* key, float x, float y, float scale, float wrapWidth, float r, float g, float b) {
+    if (key == NULL || key->text == NULL || currentFont == NULL || drawsDropped(app)) {
+        return;
+    }
+
+    float glyphScale;
+    SFontSize* size = getGlyphFontSize(currentFont, STDUI_DEFAULT_FONT_SIZE * scale, &glyphScale);
+    const STextRun* run = getTextRun(size, key, wrapWidth > 0.0f ? wrapWidth / glyphScale : 0.0f);
+    if (run == NULL || run->glyphCount == 0) {
+        return;
+    }
+
+    STextGLState saved;
+    beginTextDraw(app, currentFont->mode, r, g, b, &saved);
+
+    // y is the top of the first line, glyph positions come from the cached layout.
+    float baseline = y + size->ascent * glyphScale;
+    for (int i = 0; i < run->glyphCount; i++) {
+        const SRunGlyph* placed = &run->glyphs[i];
+        float fallbackScale;
+        const SGlyph* glyph = getGlyph(&glyphCache, size, currentFont->mode, placed->codepoint, &fallbackScale);
+        if (glyph) {
+            pushGlyphQuad(glyph, x + placed->x * glyphScale, baseline + placed->y * glyphScale, glyphScale * fallbackScale);
+        }
+    }
+
+    endTextDraw(&saved);
+}
+
+// Draw text with its top left corner at (x, y), wrapping lines at spaces to fit wrapWidth.
+void SDrawTextWrapped(SApplication *app, const char* text, float x, float y, float scale, float wrapWidth, float r, float g, float b) {
+    if (text == NULL) {
+        return;
+    }
+    STextKey key = SMakeTextKey(text, -1);
+    SDrawTextKeyed(app, &key, x, y, scale, wrapWidth, r, g, b);
+}
+
+void SDrawText(SApplication *app, const char* text, float x, float y, float scale, float r, float g, float b) {
+    SDrawTextWrapped(app, text, x, y, scale, 0.0f, r, g, b);
+}
+
+// Draw a paragraph with its top left corner at (x, y).
+void SDrawParagraph(SApplication *app, SParagraph* paragraph, float x, float y, float r, float g, float b) {
+    if (paragraph == NULL || drawsDropped(app)) {
+        return;
+    }
+    updateParagraphLayout(paragraph);
+    if (paragraph->lineCount == 0) {
+        return;
+    }
+
+    // Lines are laid out at the paragraph's pixel size, glyphs may come from another size (SDF).
+    SFont* font = paragraph->font;
+    SFontSize* metrics = getFontSize(font, (float)paragraph->pixelSize);
+    float glyphScale;
+    SFontSize* size = getGlyphFontSize(font, (float)paragraph->pixelSize, &glyphScale);
+    int visible = visibleParagraphLines(paragraph, metrics->lineHeight);
+
+    float boxWidth = paragraph->maxWidth;
+    if (boxWidth <= 0.0f) {
+        SMeasureParagraph(paragraph, &boxWidth, NULL);
+    }
+
+    // U+2026 if the font has it, three dots otherwise.
+    int ellipsis = fontHasGlyph(font, 0x2026) ? 0x2026 : '.';
+    int ellipsisCount = ellipsis == '.' ? 3 : 1;
+    float ellipsisAdvance = fontAdvance(font, ellipsis) * metrics->scale;
+
+    STextGLState saved;
+    beginTextDraw(app, font->mode, r, g, b, &saved);
+
+    for (int l = 0; l < visible; l++) {
+        const SParaLine* line = &paragraph->lines[l];
+        int glyphCount = line->glyphCount;
+        float lineWidth = line->width;
+
+        // Cut the last visible line so the ellipsis fits when lines are hidden below it.
+        bool truncated = paragraph->ellipsis && (l == visible - 1) && visible < paragraph->lineCount;
+        if (truncated) {
+            float limit = (paragraph->maxWidth > 0.0f ? paragraph->maxWidth : lineWidth + ellipsisAdvance * ellipsisCount)
+                        - ellipsisAdvance * ellipsisCount;
+            lineWidth = 0.0f;
+            for (glyphCount = 0; glyphCount < line->glyphCount; glyphCount++) {
+                const SParaGlyph* glyph = &paragraph->glyphs[line->firstGlyph + glyphCount];
+                if (glyph->x + glyph->advance > limit) {
+                    break;
+                }
+                lineWidth = glyph->x + glyph->advance;
+            }
+            lineWidth += ellipsisAdvance * ellipsisCount;
+        }
+
+        float lineX = x;
+        if (paragraph->align == STEXT_ALIGN_CENTER) {
+            lineX += (boxWidth - lineWidth) * 0.5f;
+        } else if (paragraph->align == STEXT_ALIGN_RIGHT) {
+            lineX += boxWidth - lineWidth;
+        }
+        float baseline = y + metrics->ascent + l * metrics->lineHeight;
+
+        for (int i = 0; i < glyphCount; i++) {
+            const SParaGlyph* placed = &paragraph->glyphs[line->firstGlyph + i];
+            float fallbackScale;
+            const SGlyph* glyph = getGlyph(&glyphCache, size, font->mode, placed->codepoint, &fallbackScale);
+            if (glyph) {
+                pushGlyphQuad(glyph, lineX + placed->x, baseline, glyphScale * fallbackScale);
+            }
+        }
+
+        if (truncated) {
+            float penX = lineX + lineWidth - ellipsisAdvance * ellipsisCount;
+            float fallbackScale;
+            const SGlyph* glyph = getGlyph(&glyphCache, size, font->mode, ellipsis, &fallbackScale);
+            for (int i = 0; glyph && i < ellipsisCount; i++) {
+                pushGlyphQuad(glyph, penX + i * ellipsisAdvance, baseline, glyphScale * fallbackScale);
+            }
+        }
+    }
+
+    endTextDraw(&saved);
+}
+
+
+// Text grids
+
+// A fixed width grid of cells for terminals and logs. The resolved cells live in an integer
+// texture and the whole grid is drawn with one quad, the fragment shader fetches each pixel's
+// cell and its glyph from the atlas. Only rows changed since the last draw are uploaded, and
+// scrolling moves a ring offset instead of rewriting the cells.
+typedef struct {
+    uint32_t codepoint;
+    uint32_t fg, bg; // RGBA8, red in the low byte.
+} STextCell;
+
+// Resolved cells pack the atlas position as x | y << 12 | page << 24, see resolveTextGrid().
+#if STDUI_ATLAS_PAGE_SIZE > 4096 || STDUI_ATLAS_MAX_PAGES > 32
+#error "Text grids need STDUI_ATLAS_PAGE_SIZE <= 4096 and STDUI_ATLAS_MAX_PAGES <= 32"
+#endif
+
+typedef struct {
+    SFont* font;
+    int pixelSize;
+    int columns, rows;
+    int cellWidth, cellHeight; // In pixels.
+
+    STextCell* cells;          // Stored by physical row, see textGridRow().
+    uint32_t* resolved;        // Per cell: atlas position, glyph box, fg, bg (the texture contents).
+    bool* dirty;               // Per physical row.
+    unsigned int* rowPages;    // Per physical row, bit per atlas page its glyphs use.
+    int scroll;                // Physical row of grid row 0.
+    unsigned int generation;   // Glyph cache generation the resolved cells refer to.
+
+    GLuint texture;
+} STextGrid;
+
+static inline uint32_t packColor(SColor color) {
+    uint32_t r = (uint32_t)(fminf(fmaxf(color.r, 0.0f), 1.0f) * 255.0f + 0.5f);
+    uint32_t g = (uint32_t)(fminf(fmaxf(color.g, 0.0f), 1.0f) * 255.0f + 0.5f);
+    uint32_t b = (uint32_t)(fminf(fmaxf(color.b, 0.0f), 1.0f) * 255.0f + 0.5f);
+    uint32_t a = (uint32_t)(fminf(fmaxf(color.a, 0.0f), 1.0f) * 255.0f + 0.5f);
+    return r | (g << 8) | (b << 16) | (a << 24);
+}
+
+static inline int textGridRow(const STextGrid* grid, int row) {
+    return (row + grid->scroll) % grid->rows;
+}
+
+static void clearTextGridRow(STextGrid* grid, int physicalRow, uint32_t bg) {
+    STextCell* cell = &grid->cells[physicalRow * grid->columns];
+    for (int i = 0; i < grid->columns; i++) {
+        cell[i].codepoint = ' ';
+        cell[i].fg = 0xFFFFFFFF;
+        cell[i].bg = bg;
+    }
+    grid->dirty[physicalRow] = true;
+}
+
+// Create a columns*rows grid, font NULL uses the current font, scale 1 is the default 24px.
+STextGrid* SCreateTextGrid(SFont* font, float scale, int columns, int rows) {
+    if (!font) {
+        font = currentFont;
+    }
+    if (!font || columns <= 0 || rows <= 0) {
+        fprintf(stderr, "ERROR: Invalid text grid\n");
+        return NULL;
+    }
+
+    STextGrid* grid = (STextGrid*)calloc(1, sizeof(STextGrid));
+    if (!grid) {
+        fprintf(stderr, "ERROR: Failed to allocate text grid\n");
+        return NULL;
+    }
+    grid->cells = (STextCell*)malloc(columns * rows * sizeof(STextCell));
+    grid->resolved = (uint32_t*)malloc(columns * rows * 4 * sizeof(uint32_t));
+    grid->dirty = (bool*)malloc(rows * sizeof(bool));
+    grid->rowPages = (unsigned int*)calloc(rows, sizeof(unsigned int));
+    if (!grid->cells || !grid->resolved || !grid->dirty || !grid->rowPages) {
+        fprintf(stderr, "ERROR: Failed to allocate text grid\n");
+        free(grid->cells);
+        free(grid->resolved);
+        free(grid->dirty);
+        free(grid->rowPages);
+        free(grid);
+        return NULL;
+    }
+
+    SFontSize* size = getFontSize(font, STDUI_DEFAULT_FONT_SIZE * scale);
+    grid->font = font;
+    grid->pixelSize = size->pixelSize;
+    grid->columns = columns;
+    grid->rows = rows;
+    grid->cellWidth = (int)ceilf(fontAdvance(font, 'M') * size->scale);
+    grid->cellHeight = (int)ceilf(size->lineHeight);
+    for (int i = 0; i < rows; i++) {
+        clearTextGridRow(grid, i, 0);
+    }
+
+    GLint prevTexture;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTexture);
+    glGenTextures(1, &grid->texture);
+    glBindTexture(GL_TEXTURE_2D, grid->texture);
+    if (stduiGL.textureStorage) {
+        stduiGL.TexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA32UI, columns, rows);
+    } else {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA32UI, columns, rows, 0, GL_RGBA_INTEGER, GL_UNSIGNED_INT, NULL);
+    }
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glBindTexture(GL_TEXTURE_2D, prevTexture);
+
+    return grid;
+}
+
+void SDestroyTextGrid(STextGrid* grid) {
+    if (!grid) {
+        return;
+    }
+    glDeleteTextures(1, &grid->texture);
+    free(grid->cells);
+    free(grid->resolved);
+    free(grid->dirty);
+    free(grid->rowPages);
+    free(grid);
+}
+
+void SSetTextGridCell(STextGrid* grid, int column, int row, int codepoint, SColor fg, SColor bg) {
+    if (column < 0 || column >= grid->columns || row < 0 || row >= grid->rows) {
+        return;
+    }
+    int physicalRow = textGridRow(grid, row);
+    STextCell* cell = &grid->cells[physicalRow * grid->columns + column];
+    cell->codepoint = (uint32_t)codepoint;
+    cell->fg = packColor(fg);
+    cell->bg = packColor(bg);
+    grid->dirty[physicalRow] = true;
+}
+
+// Write UTF-8 text into a row starting at column, stops at the end of the row or a newline.
+// Returns the number of cells written.
+int STextGridPrint(STextGrid* grid, int column, int row, const char* text, SColor fg, SColor bg) {
+    if (!text || row < 0 || row >= grid->rows) {
+        return 0;
+    }
+    uint32_t packedFg = packColor(fg), packedBg = packColor(bg);
+    int physicalRow = textGridRow(grid, row);
+    STextCell* cells = &grid->cells[physicalRow * grid->columns];
+
+    int written = 0;
+    while (*text && *text != '\n' && column < grid->columns) {
+        int c = decodeUTF8(&text, NULL);
+        if (column >= 0) {
+            cells[column].codepoint = (uint32_t)c;
+            cells[column].fg = packedFg;
+            cells[column].bg = packedBg;
+            written++;
+        }
+        column++;
+    }
+    if (written) {
+        grid->dirty[physicalRow] = true;
+    }
+    return written;
+}
+
+void SClearTextGrid(STextGrid* grid, SColor bg) {
+    uint32_t packed = packColor(bg);
+    for (int i = 0; i < grid->rows; i++) {
+        clearTextGridRow(grid, i, packed);
+    }
+}
+
+// Scroll the contents up by lines (down if negative), rows that come in are cleared to bg.
+// Only the cleared rows are uploaded again.
+void SScrollTextGrid(STextGrid* grid, int lines, SColor bg) {
+    if (lines <= -grid->rows || lines >= grid->rows) {
+        SClearTextGrid(grid, bg);
+        return;
+    }
+
+    uint32_t packed = packColor(bg);
+    grid->scroll = ((grid->scroll + lines) % grid->rows + grid->rows) % grid->rows;
+    if (lines > 0) {
+        for (int i = grid->rows - lines; i < grid->rows; i++) {
+            clearTextGridRow(grid, textGridRow(grid, i), packed);
+        }
+    } else {
+        for (int i = 0; i < -lines; i++) {
+            clearTextGridRow(grid, textGridRow(grid, i), packed);
+        }
+    }
+}
+
+// Look up the glyphs of the dirty rows and pack them the way the grid shader reads them:
+// x | y << 12 | page << 24, then w | h << 8 | (xoff + 128) << 16 | (yoff + 128) << 24, fg, bg.
+// Returns false if the glyph cache evicted a page meanwhile, everything has to be resolved again.
+static bool resolveTextGrid(STextGrid* grid, SFontSize* size) {
+    unsigned int generation = glyphCache.generation;
+
+    for (int row = 0; row < grid->rows; row++) {
+        if (!grid->dirty[row]) {
             continue;
         }
-        
-        // Get character data from the baked font
-        stbtt_aligned_quad q;
-        stbtt_GetBakedQuad(charData, fontTexWidth, fontTexHeight, c - 32, &x, &y, &q, 1);
-        
-        // Scale the quad
-        float x0 = q.x0 * scale;
-        float y0 = q.y0 * scale;
-        float x1 = q.x1 * scale;
-        float y1 = q.y1 * scale;
-        
-        // Adjust Y position (stb_truetype assumes y increases upwards, OpenGL usually has y increasing downwards)
-        float yOffset = startY - y0;
-        y0 += yOffset;
-        y1 += yOffset;
-        
-        // Create vertices for this character
-        float vertices[6][4] = {
-            { x0, y0, q.s0, q.t0 },
-            { x0, y1, q.s0, q.t1 },
-            { x1, y1, q.s1, q.t1 },
-            
-            { x0, y0, q.s0, q.t0 },
-            { x1, y1, q.s1, q.t1 },
-            { x1, y0, q.s1, q.t0 }
-        };
-        
-        // Update VBO
-        glBindBuffer(GL_ARRAY_BUFFER, textVBO);
-        glBufferSubData(GL_ARRAY_BUFFER, 0, sizeof(vertices), vertices);
-        
-        // Draw character
-        glDrawArrays(GL_TRIANGLES, 0, 6);
+
+        bool pending = false;
+        grid->rowPages[row] = 0;
+        const STextCell* cell = &grid->cells[row * grid->columns];
+        uint32_t* out = &grid->resolved[row * grid->columns * 4];
+        for (int i = 0; i < grid->columns; i++, cell++, out += 4) {
+            out[0] = out[1] = 0;
+            out[2] = cell->fg;
+            out[3] = cell->bg;
+
+            float fallbackScale;
+            const SGlyph* glyph = cell->codepoint > ' ' ? getGlyph(&glyphCache, size, STEXT_BITMAP, (int)cell->codepoint, &fallbackScale) : NULL;
+            if (!glyph) {
+                pending |= cell->codepoint > ' ' && glyphWorkers.mode != SGLYPH_LOAD_BLOCK;
+                continue;
+            }
+            if (glyph->pending || fallbackScale != 1.0f) {
+                pending = true; // Drawn once a worker delivers it.
+                continue;
+            }
+            if (glyph->page < 0 || glyph->w > 255 || glyph->h > 255 ||
+                glyph->xoff < -128 || glyph->xoff > 127 || glyph->yoff < -128 || glyph->yoff > 127) {
+                continue;
+            }
+            out[0] = (uint32_t)glyph->x | ((uint32_t)glyph->y << 12) | ((uint32_t)glyph->page << 24);
+            grid->rowPages[row] |= 1u << glyph->page;
+            out[1] = (uint32_t)glyph->w | ((uint32_t)glyph->h << 8) |
+                     ((uint32_t)((int)glyph->xoff + 128) << 16) | ((uint32_t)((int)glyph->yoff + 128) << 24);
+        }
+        grid->dirty[row] = pending;
+
+        if (glyphCache.generation != generation) {
+            return false;
+        }
+
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, row, grid->columns, 1, GL_RGBA_INTEGER, GL_UNSIGNED_INT,
+                        &grid->resolved[row * grid->columns * 4]);
     }
-    
-    
+
+    grid->generation = generation;
+    return true;
+}
+
+// Draw the grid with its top left corner at (x, y).
+void SDrawTextGrid(SApplication *app, STextGrid* grid, float x, float y) {
+    if (!grid || drawsDropped(app)) {
+        return;
+    }
+
+    GLint prevProgram, prevVAO, prevTexture, prevArrayTexture, prevActive;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
+    glGetIntegerv(GL_ACTIVE_TEXTURE, &prevActive);
+    GLboolean prevBlendEnabled = glIsEnabled(GL_BLEND);
+    GLint prevBlendSrc, prevBlendDst;
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &prevBlendSrc);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &prevBlendDst);
+
+    glActiveTexture(GL_TEXTURE1);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D, &prevTexture);
+    glBindTexture(GL_TEXTURE_2D, grid->texture);
+    glActiveTexture(GL_TEXTURE0);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &prevArrayTexture);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, fontTexture);
+
+    // Rows that are not resolved again still sample their pages, keep those from being evicted.
+    glyphCache.tick++;
+    watchGlyphJobs(app);
+    collectGlyphJobs(&glyphCache, false);
+    if (grid->generation == glyphCache.generation) {
+        unsigned int pages = 0;
+        for (int row = 0; row < grid->rows; row++) {
+            pages |= grid->rowPages[row];
+        }
+        for (int i = 0; i < glyphCache.pageCount; i++) {
+            if (pages & (1u << i)) {
+                glyphCache.pages[i].lastUsed = glyphCache.tick;
+            }
+        }
+    }
+
+    // Grids always use coverage bitmaps, the cells are sampled texel for texel.
+    SFontSize* size = getFontSize(grid->font, (float)grid->pixelSize);
+
+    glActiveTexture(GL_TEXTURE1);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (grid->generation != glyphCache.generation) {
+            memset(grid->dirty, 1, grid->rows * sizeof(bool));
+        }
+        if (resolveTextGrid(grid, size)) {
+            break;
+        }
+    }
+    glActiveTexture(GL_TEXTURE0);
+    uploadGlyphAtlas();
+
+    GLfloat projection[16] = {
+        2.0f / SGetCurrentWindowWidth(app), 0.0f, 0.0f, 0.0f,
+        0.0f, -2.0f / SGetCurrentWindowHeight(app), 0.0f, 0.0f,
+        0.0f, 0.0f, -1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f
+    };
+    glUseProgram(textGridShader);
+    glUniformMatrix4fv(glGetUniformLocation(textGridShader, "projection"), 1, GL_FALSE, projection);
+    glUniform2f(glGetUniformLocation(textGridShader, "origin"), roundf(x), roundf(y));
+    glUniform2f(glGetUniformLocation(textGridShader, "size"),
+                (float)(grid->columns * grid->cellWidth), (float)(grid->rows * grid->cellHeight));
+    glUniform2i(glGetUniformLocation(textGridShader, "cellSize"), grid->cellWidth, grid->cellHeight);
+    glUniform1i(glGetUniformLocation(textGridShader, "rows"), grid->rows);
+    glUniform1i(glGetUniformLocation(textGridShader, "scroll"), grid->scroll);
+    glUniform1i(glGetUniformLocation(textGridShader, "baseline"), (int)roundf(size->ascent));
+    glUniform1i(glGetUniformLocation(textGridShader, "text"), 0);
+    glUniform1i(glGetUniformLocation(textGridShader, "cells"), 1);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBindVertexArray(textVAO);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
     // Restore previous OpenGL state
     glBindVertexArray(prevVAO);
-    glBindBuffer(GL_ARRAY_BUFFER, prevBuffer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, prevArrayTexture);
+    glActiveTexture(GL_TEXTURE1);
     glBindTexture(GL_TEXTURE_2D, prevTexture);
+    glActiveTexture(prevActive);
+    glUseProgram(prevProgram);
+    if (!prevBlendEnabled)
+        glDisable(GL_BLEND);
+    glBlendFunc(prevBlendSrc, prevBlendDst);
+}
+
+
+// Text blobs
+
+// Text laid out once into glyph instances that stay in a static GPU buffer, so drawing it
+// again is one instanced draw with no CPU glyph work. Every blob owns a range of the shared
+// instance buffer; the instances are only rebuilt when the glyph cache evicts a page they use
+// or the font changes mode.
+typedef struct {
+    char* text;
+    SFont* font;
+    STextMode mode;            // Mode the instances were built for.
+    float pixelSize;
+    float wrapWidth;
+    float width, height;       // Size of the laid out text in pixels.
+
+    int first, count;          // Instance range in textBlobVBO.
+    unsigned int generation;   // Glyph cache generation when the instances were built.
+    unsigned int pages;        // Bit per atlas page the instances use.
+    bool pending;              // Some glyphs were still on a worker, rebuild on the next draw.
+} STextBlob;
+
+#define STDUI_BLOB_INSTANCE_FLOATS 9 // x0, y0, x1, y1, s0, t0, s1, t1, page
+
+// Reserve count instances in the blob buffer, first fit, growing the buffer if needed.
+static int allocateBlobRange(int count) {
+    for (int i = 0; i < textBlobFreeCount; i++) {
+        STextBlobRange* range = &textBlobFree[i];
+        if (range->count >= count) {
+            int first = range->first;
+            range->first += count;
+            range->count -= count;
+            if (range->count == 0) {
+                memmove(range, range + 1, (textBlobFreeCount - i - 1) * sizeof(STextBlobRange));
+                textBlobFreeCount--;
+            }
+            return first;
+        }
+    }
+
+    if (textBlobEnd + count > textBlobCapacity) {
+        int capacity = textBlobCapacity ? textBlobCapacity * 2 : 4096;
+        while (capacity < textBlobEnd + count) capacity *= 2;
+
+        // Copy the existing instances over, blobs keep their offsets.
+        GLuint buffer;
+        GLsizeiptr size = (GLsizeiptr)capacity * STDUI_BLOB_INSTANCE_FLOATS * sizeof(float);
+        GLsizeiptr used = (GLsizeiptr)textBlobEnd * STDUI_BLOB_INSTANCE_FLOATS * sizeof(float);
+        if (stduiGL.directStateAccess) {
+            stduiGL.CreateBuffers(1, &buffer);
+            stduiGL.NamedBufferData(buffer, size, NULL, GL_STATIC_DRAW);
+            if (textBlobVBO && used > 0) {
+                stduiGL.CopyNamedBufferSubData(textBlobVBO, buffer, 0, 0, used);
+            }
+        } else {
+            glGenBuffers(1, &buffer);
+            glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+            glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STATIC_DRAW);
+            if (textBlobVBO && used > 0) {
+                glBindBuffer(GL_COPY_READ_BUFFER, textBlobVBO);
+                glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, used);
+            }
+        }
+        glDeleteBuffers(1, &textBlobVBO);
+        textBlobVBO = buffer;
+        textBlobCapacity = capacity;
+
+        #ifdef STDUI_VERBAL_DEBUG
+        printf("STATUS: Text blob buffer grown to %d glyphs.\n", capacity);
+        #endif
+    }
+
+    int first = textBlobEnd;
+    textBlobEnd += count;
+    return first;
+}
+
+static void freeBlobRange(int first, int count) {
+    if (count == 0) {
+        return;
+    }
+
+    // Insert sorted, then merge with the neighbours and give the tail back to textBlobEnd.
+    if (textBlobFreeCount == textBlobFreeCapacity) {
+        int capacity = textBlobFreeCapacity ? textBlobFreeCapacity * 2 : 16;
+        STextBlobRange* ranges = (STextBlobRange*)realloc(textBlobFree, capacity * sizeof(STextBlobRange));
+        if (!ranges) {
+            return; // The range is leaked, not fatal.
+        }
+        textBlobFree = ranges;
+        textBlobFreeCapacity = capacity;
+    }
+    int i = 0;
+    while (i < textBlobFreeCount && textBlobFree[i].first < first) i++;
+    memmove(&textBlobFree[i + 1], &textBlobFree[i], (textBlobFreeCount - i) * sizeof(STextBlobRange));
+    textBlobFree[i].first = first;
+    textBlobFree[i].count = count;
+    textBlobFreeCount++;
+
+    if (i + 1 < textBlobFreeCount && textBlobFree[i].first + textBlobFree[i].count == textBlobFree[i + 1].first) {
+        textBlobFree[i].count += textBlobFree[i + 1].count;
+        memmove(&textBlobFree[i + 1], &textBlobFree[i + 2], (textBlobFreeCount - i - 2) * sizeof(STextBlobRange));
+        textBlobFreeCount--;
+    }
+    if (i > 0 && textBlobFree[i - 1].first + textBlobFree[i - 1].count == textBlobFree[i].first) {
+        textBlobFree[i - 1].count += textBlobFree[i].count;
+        memmove(&textBlobFree[i], &textBlobFree[i + 1], (textBlobFreeCount - i - 1) * sizeof(STextBlobRange));
+        textBlobFreeCount--;
+        i--;
+    }
+    if (textBlobFree[i].first + textBlobFree[i].count == textBlobEnd) {
+        textBlobEnd = textBlobFree[i].first;
+        textBlobFreeCount--;
+    }
+}
+
+// True when a page the instances sample was evicted, or the cache was made again, since the
+// blob was built. Evicting other pages leaves the blob alone.
+static bool textBlobEvicted(const STextBlob* blob) {
+    for (int i = 0; i < STDUI_ATLAS_MAX_PAGES; i++) {
+        if ((blob->pages & (1u << i)) &&
+            (i >= glyphCache.pageCount || glyphCache.pages[i].generation > blob->generation)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Lay the text out and write its glyph instances into the blob's range.
+static bool buildTextBlob(STextBlob* blob) {
+    float glyphScale;
+    SFontSize* size = getGlyphFontSize(blob->font, blob->pixelSize, &glyphScale);
+    STextKey key = SMakeTextKey(blob->text, -1);
+    const STextRun* run = getTextRun(size, &key, blob->wrapWidth > 0.0f ? blob->wrapWidth / glyphScale : 0.0f);
+    if (!run) {
+        return false;
+    }
+
+    // The glyph count only changes with the text, but be safe if a mode switch changes it.
+    if (run->glyphCount != blob->count) {
+        freeBlobRange(blob->first, blob->count);
+        blob->count = run->glyphCount;
+        blob->first = blob->count ? allocateBlobRange(blob->count) : 0;
+    }
+
+    blob->mode = blob->font->mode;
+    blob->width = run->width * glyphScale;
+    blob->height = run->height * glyphScale;
+    blob->pages = 0;
+    blob->pending = false;
+    if (blob->count == 0) {
+        blob->generation = glyphCache.generation;
+        return true;
+    }
+
+    float* instances = (float*)calloc((size_t)blob->count * STDUI_BLOB_INSTANCE_FLOATS, sizeof(float));
+    if (!instances) {
+        fprintf(stderr, "ERROR: Failed to allocate text blob\n");
+        return false;
+    }
+
+    glyphCache.tick++;
+    const float texel = 1.0f / STDUI_ATLAS_PAGE_SIZE;
+    for (int i = 0; i < run->glyphCount; i++) {
+        const SRunGlyph* placed = &run->glyphs[i];
+        float fallbackScale;
+        const SGlyph* glyph = getGlyph(&glyphCache, size, blob->mode, placed->codepoint, &fallbackScale);
+        if (!glyph || fallbackScale != 1.0f) {
+            blob->pending |= glyphWorkers.mode != SGLYPH_LOAD_BLOCK;
+        }
+        if (!glyph || glyph->page < 0) {
+            continue; // Zero sized instance.
+        }
+
+        float scale = glyphScale * fallbackScale;
+        float x0 = placed->x * glyphScale + glyph->xoff * scale;
+        float y0 = (size->ascent + placed->y) * glyphScale + glyph->yoff * scale;
+        if (scale == 1.0f) {
+            x0 = roundf(x0);
+        }
+        float* out = &instances[i * STDUI_BLOB_INSTANCE_FLOATS];
+        out[0] = x0;
+        out[1] = y0;
+        out[2] = x0 + glyph->w * scale;
+        out[3] = y0 + glyph->h * scale;
+        out[4] = glyph->x * texel;
+        out[5] = glyph->y * texel;
+        out[6] = (glyph->x + glyph->w) * texel;
+        out[7] = (glyph->y + glyph->h) * texel;
+        out[8] = (float)glyph->page;
+        blob->pages |= 1u << glyph->page;
+    }
+    blob->generation = glyphCache.generation;
+
+    GLintptr offset = (GLintptr)blob->first * STDUI_BLOB_INSTANCE_FLOATS * sizeof(float);
+    GLsizeiptr bytes = (GLsizeiptr)blob->count * STDUI_BLOB_INSTANCE_FLOATS * sizeof(float);
+    if (stduiGL.directStateAccess) {
+        stduiGL.NamedBufferSubData(textBlobVBO, offset, bytes, instances);
+    } else {
+        glBindBuffer(GL_ARRAY_BUFFER, textBlobVBO);
+        glBufferSubData(GL_ARRAY_BUFFER, offset, bytes, instances);
+    }
+    free(instances);
+    return true;
+}
+
+// Lay out text with the current font once, see SDrawTextWrapped for scale and wrapWidth.
+STextBlob* SCreateTextBlob(const char* text, float scale, float wrapWidth) {
+    if (!text || !currentFont) {
+        return NULL;
+    }
+
+    STextBlob* blob = (STextBlob*)calloc(1, sizeof(STextBlob));
+    size_t length = strlen(text);
+    if (blob) {
+        blob->text = (char*)malloc(length + 1);
+    }
+    if (!blob || !blob->text) {
+        fprintf(stderr, "ERROR: Failed to allocate text blob\n");
+        free(blob);
+        return NULL;
+    }
+    memcpy(blob->text, text, length + 1);
+    blob->font = currentFont;
+    blob->pixelSize = STDUI_DEFAULT_FONT_SIZE * scale;
+    blob->wrapWidth = wrapWidth;
+
+    GLint prevBuffer;
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+    bool built = buildTextBlob(blob);
+    glBindBuffer(GL_ARRAY_BUFFER, prevBuffer);
+    if (!built) {
+        free(blob->text);
+        free(blob);
+        return NULL;
+    }
+    return blob;
+}
+
+void SDestroyTextBlob(STextBlob* blob) {
+    if (!blob) {
+        return;
+    }
+    freeBlobRange(blob->first, blob->count);
+    free(blob->text);
+    free(blob);
+}
+
+// Draw a blob with its top left corner at (x, y).
+void SDrawTextBlob(SApplication *app, STextBlob* blob, float x, float y, float r, float g, float b) {
+    if (!blob || blob->count == 0 || drawsDropped(app)) {
+        return;
+    }
+
+    GLint prevProgram, prevTexture, prevVAO, prevBuffer;
+    glGetIntegerv(GL_CURRENT_PROGRAM, &prevProgram);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &prevTexture);
+    glGetIntegerv(GL_VERTEX_ARRAY_BINDING, &prevVAO);
+    glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &prevBuffer);
+    GLboolean prevBlendEnabled = glIsEnabled(GL_BLEND);
+    GLint prevBlendSrc, prevBlendDst;
+    glGetIntegerv(GL_BLEND_SRC_ALPHA, &prevBlendSrc);
+    glGetIntegerv(GL_BLEND_DST_ALPHA, &prevBlendDst);
+
+    watchGlyphJobs(app);
+    collectGlyphJobs(&glyphCache, false);
+    if (textBlobEvicted(blob) || blob->mode != blob->font->mode || blob->pending) {
+        buildTextBlob(blob);
+    }
+
+    // Mark the pages this blob samples as used, so LRU eviction picks pages nothing draws.
+    glyphCache.tick++;
+    for (int i = 0; i < glyphCache.pageCount; i++) {
+        if (blob->pages & (1u << i)) {
+            glyphCache.pages[i].lastUsed = glyphCache.tick;
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, fontTexture);
+    uploadGlyphAtlas();
+
+    GLfloat projection[16] = {
+        2.0f / SGetCurrentWindowWidth(app), 0.0f, 0.0f, 0.0f,
+        0.0f, -2.0f / SGetCurrentWindowHeight(app), 0.0f, 0.0f,
+        0.0f, 0.0f, -1.0f, 0.0f,
+        -1.0f, 1.0f, 0.0f, 1.0f
+    };
+    GLuint program = blob->mode == STEXT_SDF ? textBlobSDFShader : textBlobShader;
+    glUseProgram(program);
+    glUniformMatrix4fv(glGetUniformLocation(program, "projection"), 1, GL_FALSE, projection);
+    glUniform2f(glGetUniformLocation(program, "origin"), roundf(x), roundf(y));
+    glUniform3f(glGetUniformLocation(program, "textColor"), r, g, b);
+    glUniform1i(glGetUniformLocation(program, "text"), 0);
+
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Point the instance attributes at the blob's range of the shared buffer.
+    const GLsizei stride = STDUI_BLOB_INSTANCE_FLOATS * sizeof(float);
+    const GLintptr base = (GLintptr)blob->first * stride;
+    glBindVertexArray(textBlobVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, textBlobVBO);
+    glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, stride, (void*)base);
+    glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, stride, (void*)(base + 4 * sizeof(float)));
+    glVertexAttribPointer(2, 1, GL_FLOAT, GL_FALSE, stride, (void*)(base + 8 * sizeof(float)));
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, blob->count);
+
+    // Restore previous OpenGL state
+    glBindVertexArray(prevVAO);
+    glBindBuffer(GL_ARRAY_BUFFER, prevBuffer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, prevTexture);
     glUseProgram(prevProgram);
-    
-    // Restore blend state
     if (!prevBlendEnabled)
         glDisable(GL_BLEND);
     glBlendFunc(prevBlendSrc, prevBlendDst);
@@ -909,4 +2082,4 @@ void SDrawText(SApplication *app, const char* text, float x, float y, float scal
 
 
 
-#endif //WIDGETS_H 
+#endif //WIDGETS_H
@@ -2,7 +2,655 @@
 #ifndef STDUI_NO_STDLIB
 #include <stdio.h>
 #include <stdbool.h>
-#endif 
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#endif
+
+#ifndef STDUI_EVENTS
+#define STDUI_EVENTS
+
+// Input is drained from the window system once per SEventProcess() call into a ring of typed
+// events, read them with SPollEvent(). Consecutive motion and resize events are merged.
+typedef enum {
+    SEVENT_NONE,
+    SEVENT_BUTTON_PRESS,
+    SEVENT_BUTTON_RELEASE,
+    SEVENT_KEY_PRESS,
+    SEVENT_KEY_RELEASE,
+    SEVENT_SCROLL,
+    SEVENT_MOTION,
+    SEVENT_RESIZE,
+    SEVENT_FOCUS_IN,
+    SEVENT_FOCUS_OUT,
+    SEVENT_CLOSE
+} SEventType;
+
+// Modifier bits in SEvent.modifiers and SInputState.modifiers.
+#define SMOD_SHIFT     0x01
+#define SMOD_CONTROL   0x02
+#define SMOD_ALT       0x04
+#define SMOD_SUPER     0x08
+#define SMOD_CAPS_LOCK 0x10
+#define SMOD_NUM_LOCK  0x20
+
+typedef struct {
+    SEventType type;
+    float x, y;              // Pointer position for button, scroll and motion events.
+    int button;              // 1 left, 2 middle, 3 right, 4 back, 5 forward, higher for extra buttons.
+    unsigned int key;        // KeySym on X11, virtual key code on Windows.
+    float scrollX, scrollY;  // Wheel steps, positive is up / right.
+    int width, height;       // New size for resize events.
+    unsigned int modifiers;  // SMOD_* bits held when the event happened.
+    unsigned long time;      // Server timestamp in milliseconds, 0 for events that carry none.
+} SEvent;
+
+#ifndef STDUI_EVENT_QUEUE_SIZE
+#define STDUI_EVENT_QUEUE_SIZE 512
+#endif
+
+// Input log for SRecordInput() and SReplayInput(). The file is the magic followed by one
+// STDUI_INPUT_RECORD_SIZE byte record per input event, in host byte order.
+#define STDUI_INPUT_LOG_MAGIC "SINPUT01"
+#define STDUI_INPUT_RECORD_SIZE 32
+
+typedef struct {
+    FILE* file;
+    bool replaying;
+    unsigned long frame;     // SEventProcess() calls since the log was opened.
+    bool lateSample;         // Events come from sampleInputLate(), see setLateSample().
+    bool havePending;        // Replay reads one record ahead.
+    unsigned long pendingFrame;
+    SEvent pending;
+} SInputLog;
+
+typedef struct {
+    SEvent events[STDUI_EVENT_QUEUE_SIZE];
+    int head, count;
+    unsigned int dropped;    // Events lost because nobody polled, the oldest go first.
+    SInputLog* log;          // Set while input is recorded or replayed.
+} SEventQueue;
+
+// State after every event drained so far.
+typedef struct {
+    float mouseX, mouseY;
+    unsigned int buttons;    // Bit (1 << (button - 1)) for every held button.
+    unsigned int pressed;    // Buttons pressed during the last SEventProcess() call, even if already released.
+    unsigned int released;   // Buttons released during the last SEventProcess() call.
+    float scrollX, scrollY;  // Wheel steps drained by the last SEventProcess() call.
+    unsigned int modifiers;  // SMOD_* bits from the newest input event.
+    unsigned long time;      // Timestamp of the newest event that had one.
+    bool focused;
+    bool closeRequested;
+    bool delivered;          // The edges were handed to a frame, see beginInput().
+} SInputState;
+
+static void queueEvent(SEventQueue* queue, const SEvent* event) {
+    // Merge with the newest event when both are motion or both are resizes.
+    if (queue->count > 0 && (event->type == SEVENT_MOTION || event->type == SEVENT_RESIZE)) {
+        SEvent* last = &queue->events[(queue->head + queue->count - 1) % STDUI_EVENT_QUEUE_SIZE];
+        if (last->type == event->type) {
+            *last = *event;
+            return;
+        }
+    }
+
+    if (queue->count == STDUI_EVENT_QUEUE_SIZE) {
+        queue->head = (queue->head + 1) % STDUI_EVENT_QUEUE_SIZE;
+        queue->count--;
+        queue->dropped++;
+    }
+    queue->events[(queue->head + queue->count) % STDUI_EVENT_QUEUE_SIZE] = *event;
+    queue->count++;
+}
+
+static bool dequeueEvent(SEventQueue* queue, SEvent* event) {
+    if (queue->count == 0) {
+        return false;
+    }
+    *event = queue->events[queue->head];
+    queue->head = (queue->head + 1) % STDUI_EVENT_QUEUE_SIZE;
+    queue->count--;
+    return true;
+}
+
+// Apply an event to the input state and queue it.
+static void applyEvent(SEventQueue* queue, SInputState* input, const SEvent* event) {
+    if (event->time != 0) {
+        input->time = event->time;
+    }
+
+    // Buttons past the 32 bits of the masks, possible in a replayed log, are only queued.
+    unsigned int button = event->button >= 1 && event->button <= 32 ? 1u << (event->button - 1) : 0u;
+    switch (event->type) {
+        case SEVENT_BUTTON_PRESS:
+            input->buttons |= button;
+            input->pressed |= button;
+            input->mouseX = event->x;
+            input->mouseY = event->y;
+            input->modifiers = event->modifiers;
+            break;
+        case SEVENT_BUTTON_RELEASE:
+            input->buttons &= ~button;
+            input->released |= button;
+            input->mouseX = event->x;
+            input->mouseY = event->y;
+            input->modifiers = event->modifiers;
+            break;
+        case SEVENT_KEY_PRESS:
+        case SEVENT_KEY_RELEASE:
+            input->modifiers = event->modifiers;
+            break;
+        case SEVENT_SCROLL:
+            input->scrollX += event->scrollX;
+            input->scrollY += event->scrollY;
+            input->mouseX = event->x;
+            input->mouseY = event->y;
+            input->modifiers = event->modifiers;
+            break;
+        case SEVENT_MOTION:
+            input->mouseX = event->x;
+            input->mouseY = event->y;
+            input->modifiers = event->modifiers;
+            break;
+        case SEVENT_FOCUS_IN:
+            input->focused = true;
+            break;
+        case SEVENT_FOCUS_OUT:
+            input->focused = false;
+            input->buttons = 0; // Releases go to the window that has focus now.
+            break;
+        case SEVENT_CLOSE:
+            input->closeRequested = true;
+            break;
+        default:
+            break;
+    }
+    queueEvent(queue, event);
+}
+
+// Only input goes into the log, resizes, focus and close follow the real window.
+static bool isLoggedEvent(SEventType type) {
+    return type == SEVENT_BUTTON_PRESS || type == SEVENT_BUTTON_RELEASE ||
+           type == SEVENT_KEY_PRESS || type == SEVENT_KEY_RELEASE ||
+           type == SEVENT_SCROLL || type == SEVENT_MOTION;
+}
+
+// Record layout: frame, time, key (uint32), type, button (uint8), modifiers (uint16),
+// x, y, scrollX, scrollY (float).
+// Returns false on a short write.
+static bool writeLoggedEvent(SInputLog* log, const SEvent* event) {
+    unsigned char record[STDUI_INPUT_RECORD_SIZE];
+    unsigned long built = log->lateSample && log->frame > 0 ? log->frame - 1 : log->frame;
+    uint32_t frame = (uint32_t)built, time = (uint32_t)event->time, key = event->key;
+    uint8_t type = (uint8_t)event->type, button = (uint8_t)event->button;
+    uint16_t modifiers = (uint16_t)event->modifiers;
+
+    memcpy(record + 0, &frame, 4);
+    memcpy(record + 4, &time, 4);
+    memcpy(record + 8, &key, 4);
+    memcpy(record + 12, &type, 1);
+    memcpy(record + 13, &button, 1);
+    memcpy(record + 14, &modifiers, 2);
+    memcpy(record + 16, &event->x, 4);
+    memcpy(record + 20, &event->y, 4);
+    memcpy(record + 24, &event->scrollX, 4);
+    memcpy(record + 28, &event->scrollY, 4);
+    return fwrite(record, sizeof(record), 1, log->file) == 1;
+}
+
+// Read the next record into log->pending, havePending is false at the end of the file.
+static void readLoggedEvent(SInputLog* log) {
+    unsigned char record[STDUI_INPUT_RECORD_SIZE];
+    log->havePending = fread(record, sizeof(record), 1, log->file) == 1;
+    if (!log->havePending) {
+        return;
+    }
+
+    uint32_t frame, time, key;
+    uint8_t type, button;
+    uint16_t modifiers;
+    SEvent* event = &log->pending;
+    memset(event, 0, sizeof(*event));
+    memcpy(&frame, record + 0, 4);
+    memcpy(&time, record + 4, 4);
+    memcpy(&key, record + 8, 4);
+    memcpy(&type, record + 12, 1);
+    memcpy(&button, record + 13, 1);
+    memcpy(&modifiers, record + 14, 2);
+    memcpy(&event->x, record + 16, 4);
+    memcpy(&event->y, record + 20, 4);
+    memcpy(&event->scrollX, record + 24, 4);
+    memcpy(&event->scrollY, record + 28, 4);
+
+    log->pendingFrame = frame;
+    event->time = time;
+    event->key = key;
+    event->type = (SEventType)type;
+    event->button = button;
+    event->modifiers = modifiers;
+    bool isButton = event->type == SEVENT_BUTTON_PRESS || event->type == SEVENT_BUTTON_RELEASE;
+    if (!isLoggedEvent(event->type) || (isButton && (event->button < 1 || event->button > 32))) {
+        fprintf(stderr, "ERROR: Corrupt input log record, replay stopped.\n");
+        log->havePending = false;
+    }
+}
+
+static void closeInputLog(SEventQueue* queue) {
+    SInputLog* log = queue->log;
+    if (log == NULL) {
+        return;
+    }
+    if (fclose(log->file) != 0 && !log->replaying) {
+        fprintf(stderr, "ERROR: Failed to write the end of the input log.\n");
+    }
+    memset(log, 0, sizeof(*log));
+    queue->log = NULL;
+}
+
+// Every window system event goes through here. While replaying, live input is dropped so only
+// the log drives the window.
+static void recordEvent(SEventQueue* queue, SInputState* input, const SEvent* event) {
+    SInputLog* log = queue->log;
+    if (log != NULL && isLoggedEvent(event->type)) {
+        if (log->replaying) {
+            return;
+        }
+        if (!writeLoggedEvent(log, event)) {
+            fprintf(stderr, "ERROR: Failed to write the input log, recording stopped.\n");
+            closeInputLog(queue);
+        }
+    }
+    applyEvent(queue, input, event);
+}
+
+// The late input sample runs after SEventProcess() moved the log on to the next frame, its
+// events are logged for the frame being built so a replay delivers them in the same frame.
+static void setLateSample(SEventQueue* queue, bool late) {
+    if (queue->log != NULL) {
+        queue->log->lateSample = late;
+    }
+}
+
+static bool openInputLog(SEventQueue* queue, SInputLog* log, const char* path, bool replay) {
+    closeInputLog(queue);
+    if (path == NULL) {
+        return false;
+    }
+
+    memset(log, 0, sizeof(*log));
+    log->file = fopen(path, replay ? "rb" : "wb");
+    if (log->file == NULL) {
+        fprintf(stderr, "ERROR: Could not open input log %s\n", path);
+        return false;
+    }
+
+    char magic[8];
+    if (replay) {
+        if (fread(magic, sizeof(magic), 1, log->file) != 1 || memcmp(magic, STDUI_INPUT_LOG_MAGIC, sizeof(magic)) != 0) {
+            fprintf(stderr, "ERROR: %s is not an input log.\n", path);
+            fclose(log->file);
+            log->file = NULL;
+            return false;
+        }
+        log->replaying = true;
+        readLoggedEvent(log);
+    } else if (fwrite(STDUI_INPUT_LOG_MAGIC, sizeof(magic), 1, log->file) != 1) {
+        fprintf(stderr, "ERROR: Could not write input log %s\n", path);
+        fclose(log->file);
+        log->file = NULL;
+        return false;
+    }
+    queue->log = log;
+    return true;
+}
+
+// Called once at the end of every SEventProcess(): feed the logged events of this frame and
+// move on to the next. Returns true if events were replayed.
+static bool advanceInputLog(SEventQueue* queue, SInputState* input) {
+    SInputLog* log = queue->log;
+    if (log == NULL) {
+        return false;
+    }
+
+    bool replayed = false;
+    while (log->replaying && log->havePending && log->pendingFrame <= log->frame) {
+        applyEvent(queue, input, &log->pending);
+        readLoggedEvent(log);
+        replayed = true;
+    }
+    log->frame++;
+
+    if (log->replaying && !log->havePending) {
+        closeInputLog(queue);
+    }
+    return replayed;
+}
+
+// Called at the start of every drain, scroll and click edges only cover one SEventProcess() call.
+static void resetInputEdges(SInputState* input) {
+    input->scrollX = input->scrollY = 0.0f;
+    input->pressed = input->released = 0;
+}
+
+// Start a new set of click and scroll edges once the previous set was handed to a frame.
+static void beginInput(SInputState* input) {
+    if (input->delivered) {
+        resetInputEdges(input);
+        input->delivered = false;
+    }
+}
+
+#endif // STDUI_EVENTS
+
+#ifndef STDUI_FRAME_PACING
+#define STDUI_FRAME_PACING
+
+// Frame times are measured at the end of SEndFrame(), after the swap and the frame limiter.
+#ifndef STDUI_FRAME_HISTORY
+#define STDUI_FRAME_HISTORY 240
+#endif
+
+// While a window cannot be seen its frames are neither drawn nor swapped, SEndFrame() ticks at
+// this rate instead so the app state keeps moving without spending CPU or GPU time.
+#ifndef STDUI_HIDDEN_FRAME_RATE
+#define STDUI_HIDDEN_FRAME_RATE 10
+#endif
+
+// Frame times in milliseconds over the last STDUI_FRAME_HISTORY frames, see SGetFrameStats().
+typedef struct {
+    double mean;
+    double p99;
+    double worst;
+    double refreshRate;      // Monitor refresh rate in Hz.
+    unsigned long frames;    // Frames measured since the window was created.
+    unsigned long missed;    // Frames more than half a refresh interval over their target time.
+} SFrameStats;
+
+typedef struct {
+    double times[STDUI_FRAME_HISTORY];
+    int next, count;
+    unsigned long frames, missed;
+    double lastEnd;          // Seconds on frameClock(), 0 before the first frame.
+    double deadline;         // When the frame limiter lets the next frame end.
+    double limit;            // Seconds per frame for the frame limiter, 0 when off.
+    double refreshRate;
+    double hiddenTick;       // When the last hidden frame ended, see paceHiddenFrame().
+} SFramePacer;
+
+// Monotonic seconds and an absolute sleep on that clock. X11 and Wayland share these, other
+// platforms define them with their window code.
+#if defined(__linux__)
+#include <errno.h>
+#include <time.h>
+
+static double frameClock(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static void sleepUntil(double time) {
+    struct timespec until;
+    until.tv_sec = (time_t)time;
+    until.tv_nsec = (long)((time - (double)until.tv_sec) * 1e9);
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &until, NULL) == EINTR) {
+    }
+}
+#else
+static double frameClock(void);
+static void sleepUntil(double time);
+#endif
+
+static void initFramePacer(SFramePacer* pacer, double refreshRate) {
+    memset(pacer, 0, sizeof(*pacer));
+    pacer->refreshRate = refreshRate;
+}
+
+// Called once per frame after the swap. Sleeps for the frame limiter and records the frame time.
+static void paceFrame(SFramePacer* pacer) {
+    double now = frameClock();
+
+    if (pacer->limit > 0.0) {
+        if (pacer->deadline > now) {
+            sleepUntil(pacer->deadline);
+            now = frameClock();
+        } else {
+            pacer->deadline = now; // Late, start over instead of rushing the next frames.
+        }
+        pacer->deadline += pacer->limit;
+    }
+
+    if (pacer->lastEnd > 0.0) {
+        double frameTime = now - pacer->lastEnd;
+        double refreshTime = 1.0 / pacer->refreshRate;
+        double target = pacer->limit > 0.0 ? pacer->limit : refreshTime;
+
+        pacer->times[pacer->next] = frameTime * 1000.0;
+        pacer->next = (pacer->next + 1) % STDUI_FRAME_HISTORY;
+        if (pacer->count < STDUI_FRAME_HISTORY) {
+            pacer->count++;
+        }
+        pacer->frames++;
+        if (frameTime > target + refreshTime * 0.5) {
+            pacer->missed++;
+        }
+    }
+    pacer->lastEnd = now;
+}
+
+// Called instead of paceFrame() for frames that were not shown. They stay out of the frame
+// times, the first frame shown afterwards starts measuring again.
+static void paceHiddenFrame(SFramePacer* pacer) {
+    double due = pacer->hiddenTick + 1.0 / STDUI_HIDDEN_FRAME_RATE;
+    if (due > frameClock()) {
+        sleepUntil(due);
+    }
+    pacer->hiddenTick = frameClock();
+    pacer->lastEnd = 0.0;
+    pacer->deadline = 0.0;
+}
+
+// SWaitEvents() timeout while the window is hidden, its timer ticks come at the hidden rate at most.
+static double hiddenWaitTimeout(double timeout) {
+    double interval = 1.0 / STDUI_HIDDEN_FRAME_RATE;
+    return timeout >= 0.0 && timeout < interval ? interval : timeout;
+}
+
+static int compareFrameTimes(const void* a, const void* b) {
+    double first = *(const double*)a, second = *(const double*)b;
+    return (first > second) - (first < second);
+}
+
+static SFrameStats frameStats(const SFramePacer* pacer) {
+    SFrameStats stats;
+    memset(&stats, 0, sizeof(stats));
+    stats.refreshRate = pacer->refreshRate;
+    stats.frames = pacer->frames;
+    stats.missed = pacer->missed;
+    if (pacer->count == 0) {
+        return stats;
+    }
+
+    double sorted[STDUI_FRAME_HISTORY];
+    double total = 0.0;
+    for (int i = 0; i < pacer->count; i++) {
+        sorted[i] = pacer->times[i];
+        total += sorted[i];
+    }
+    qsort(sorted, pacer->count, sizeof(double), compareFrameTimes);
+
+    stats.mean = total / pacer->count;
+    stats.p99 = sorted[(pacer->count * 99) / 100 < pacer->count - 1 ? (pacer->count * 99) / 100 : pacer->count - 1];
+    stats.worst = sorted[pacer->count - 1];
+    return stats;
+}
+
+#endif // STDUI_FRAME_PACING
+
+#ifndef STDUI_INPUT_LATENCY
+#define STDUI_INPUT_LATENCY
+
+// Input-to-photon latency is kept as a histogram of STDUI_LATENCY_BUCKETS buckets
+// STDUI_LATENCY_BUCKET_MS wide, the last bucket also counts everything slower.
+#ifndef STDUI_LATENCY_BUCKETS
+#define STDUI_LATENCY_BUCKETS 100
+#endif
+#ifndef STDUI_LATENCY_BUCKET_MS
+#define STDUI_LATENCY_BUCKET_MS 0.5
+#endif
+
+// Latency in milliseconds from the oldest input event of a frame to its swap completing, only
+// measured in low-latency mode, see SSetLowLatency() and SGetLatencyStats().
+typedef struct {
+    unsigned long buckets[STDUI_LATENCY_BUCKETS];
+    double bucketWidth;      // Milliseconds per bucket.
+    unsigned long samples;   // Frames that showed input.
+    double mean;
+    double p50;              // Percentiles are the upper edge of their bucket.
+    double p99;
+    double worst;
+} SLatencyStats;
+
+typedef struct {
+    double clockOffset;      // frameClock() minus event time, estimated from arrivals.
+    bool haveOffset;
+    double pendingInput;     // frameClock() time of the oldest input not shown yet, 0 when none.
+    unsigned long buckets[STDUI_LATENCY_BUCKETS];
+    unsigned long samples;
+    double total, worst;
+} SLatencyTracker;
+
+// Note an input event by its timestamp in milliseconds (X server time, GetMessageTime()).
+// Delivery never takes negative time, so the smallest arrival minus timestamp seen so far is
+// the closest estimate of how the event clock relates to frameClock().
+static void noteInputTime(SLatencyTracker* tracker, unsigned long time) {
+    double offset = frameClock() - (double)time / 1000.0;
+    if (!tracker->haveOffset || offset < tracker->clockOffset) {
+        tracker->clockOffset = offset;
+        tracker->haveOffset = true;
+    }
+
+    double happened = (double)time / 1000.0 + tracker->clockOffset;
+    if (tracker->pendingInput == 0.0 || happened < tracker->pendingInput) {
+        tracker->pendingInput = happened;
+    }
+}
+
+// Called with the time the swap completed, counts the frame if it showed new input.
+static void recordLatency(SLatencyTracker* tracker, double shown) {
+    if (tracker->pendingInput == 0.0) {
+        return;
+    }
+
+    double latency = (shown - tracker->pendingInput) * 1000.0;
+    tracker->pendingInput = 0.0;
+    if (latency < 0.0) {
+        latency = 0.0;
+    }
+
+    int bucket = (int)(latency / STDUI_LATENCY_BUCKET_MS);
+    tracker->buckets[bucket < STDUI_LATENCY_BUCKETS ? bucket : STDUI_LATENCY_BUCKETS - 1]++;
+    tracker->samples++;
+    tracker->total += latency;
+    if (latency > tracker->worst) {
+        tracker->worst = latency;
+    }
+}
+
+// Sleep until the latest point a frame that takes renderTime can start and still make the
+// vblank after lastShown. Does nothing before the first measured frame.
+static void waitForLateStart(double lastShown, double refreshRate, double renderTime) {
+    if (lastShown <= 0.0 || refreshRate <= 0.0) {
+        return;
+    }
+
+    double refresh = 1.0 / refreshRate;
+    double now = frameClock();
+    double vblank = lastShown + refresh;
+    while (vblank < now) {
+        vblank += refresh;
+    }
+    double start = vblank - renderTime - 0.002; // 2 ms margin for scheduling jitter.
+    if (start > now) {
+        sleepUntil(start);
+    }
+}
+
+// Running average of the time from sampling input to submitting the swap.
+static double averageRenderTime(double average, double renderTime) {
+    return average == 0.0 ? renderTime : average * 0.9 + renderTime * 0.1;
+}
+
+static SLatencyStats latencyStats(const SLatencyTracker* tracker) {
+    SLatencyStats stats;
+    memset(&stats, 0, sizeof(stats));
+    memcpy(stats.buckets, tracker->buckets, sizeof(stats.buckets));
+    stats.bucketWidth = STDUI_LATENCY_BUCKET_MS;
+    stats.samples = tracker->samples;
+    if (tracker->samples == 0) {
+        return stats;
+    }
+
+    stats.mean = tracker->total / (double)tracker->samples;
+    stats.worst = tracker->worst;
+
+    unsigned long seen = 0;
+    for (int i = 0; i < STDUI_LATENCY_BUCKETS; i++) {
+        seen += tracker->buckets[i];
+        if (stats.p50 == 0.0 && seen * 2 >= tracker->samples) {
+            stats.p50 = (i + 1) * STDUI_LATENCY_BUCKET_MS;
+        }
+        if (seen * 100 >= tracker->samples * 99) {
+            stats.p99 = (i + 1) * STDUI_LATENCY_BUCKET_MS;
+            break;
+        }
+    }
+    // Both are capped by the slowest frame, which matters for the overflow bucket.
+    stats.p50 = stats.p50 < stats.worst ? stats.p50 : stats.worst;
+    stats.p99 = stats.p99 < stats.worst ? stats.p99 : stats.worst;
+    return stats;
+}
+
+#endif // STDUI_INPUT_LATENCY
+
+#ifndef STDUI_CONTEXT_OBJECTS
+#define STDUI_CONTEXT_OBJECTS
+
+// Every window has its own GL context, all of them in one share group so programs, buffers and
+// the glyph atlas exist once. Vertex array objects are not shared, each window keeps its own.
+typedef struct {
+    unsigned int rectVAO, triangleVAO, circleVAO;
+    unsigned int textVAO, textBlobVAO;
+} SContextObjects;
+
+#ifndef STDUI_MAX_WINDOWS
+#define STDUI_MAX_WINDOWS 16
+#endif
+
+// STDUI_GLES makes every context OpenGL ES 3.0 created through EGL, for GPUs without desktop
+// GL 3.3 core. Link with -lEGL -lGLESv2 instead of -lGL. Without it EGL (Wayland) asks for the
+// same desktop core context GLX does.
+#ifdef STDUI_GLES
+#define STDUI_EGL_API EGL_OPENGL_ES_API
+#define STDUI_EGL_API_NAME "OpenGL ES 3.0"
+#define STDUI_EGL_RENDERABLE_TYPE EGL_OPENGL_ES3_BIT
+#define STDUI_EGL_CONTEXT_ATTRIBS \
+    EGL_CONTEXT_MAJOR_VERSION, 3, \
+    EGL_CONTEXT_MINOR_VERSION, 0, \
+    EGL_NONE
+#else
+#define STDUI_EGL_API EGL_OPENGL_API
+#define STDUI_EGL_API_NAME "desktop OpenGL"
+#define STDUI_EGL_RENDERABLE_TYPE EGL_OPENGL_BIT
+#define STDUI_EGL_CONTEXT_ATTRIBS \
+    EGL_CONTEXT_MAJOR_VERSION, 3, \
+    EGL_CONTEXT_MINOR_VERSION, 3, \
+    EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT, \
+    EGL_NONE
+#endif
+
+#endif // STDUI_CONTEXT_OBJECTS
 
 
 
@@ -14,93 +662,1740 @@
 #endif
 
 
-#if defined(__linux__)
+#if defined(__linux__) && defined(STDUI_WAYLAND)
+
+// Native Wayland instead of XWayland: xdg_shell toplevels drawn with EGL, redraws paced by frame
+// callbacks. Link with -lwayland-client -lwayland-egl -lEGL -lxkbcommon. xdg-shell and viewporter
+// do not ship with libwayland, generate them from wayland-protocols with wayland-scanner:
+//   wayland-scanner client-header xdg-shell.xml xdg-shell-client-protocol.h
+//   wayland-scanner private-code xdg-shell.xml xdg-shell-protocol.c
+// and the same for viewporter.xml, then build both .c files into the application. The CMake build
+// does this with -DSTDUI_WAYLAND=ON. To test without a session run
+// "weston --backend=headless-backend.so --socket=stdui-test" and set WAYLAND_DISPLAY=stdui-test.
+
+#include <wayland-client.h>
+#include <wayland-egl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <xkbcommon/xkbcommon.h>
+#include "xdg-shell-client-protocol.h"
+#include "viewporter-client-protocol.h"
+#include <linux/input-event-codes.h>
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <time.h>
+#ifdef STDUI_GLES
+#include <GLES3/gl3.h>
+#else
+#include <GL/gl.h>
+#include <GL/glext.h>
+#endif
+#include "internal/gl_loader.h"
+
+typedef struct {
+    struct wl_display *display;   // The connection every window shares, see SDisplayOpen().
+    struct wl_surface *surface;
+    struct xdg_surface *xdgSurface;
+    struct xdg_toplevel *toplevel;
+    struct wp_viewport *viewport; // NULL when the compositor has no wp_viewporter.
+    struct wl_egl_window *eglWindow;
+    struct wl_callback *frameCallback; // Requested by SEndFrame(), NULL once the compositor wants a frame.
+    double frameRequested;   // frameClock() when frameCallback was requested.
+    EGLSurface eglSurface;
+    EGLContext eglContext;
+    float mouseX;
+    float mouseY;
+    int mouseDown;
+    int width, height;       // Surface size from the last configure, in surface coordinates.
+    int viewportWidth, viewportHeight; // Size the viewport and projection were last set for.
+    float renderScale;       // Buffer pixels per surface unit, see SSetRenderScale().
+    bool configured;         // The first xdg_surface.configure arrived.
+    SEventQueue events;
+    SInputState input;
+    int wakeFd;              // eventfd written by SPostEmptyEvent() to wake SWaitEvents().
+    int swapInterval;        // 0 draws without waiting for frame callbacks.
+    SFramePacer pacer;
+    volatile int redraw;     // Set by input, SWaitEvents() timeouts and SInvalidate(), cleared by SBeginFrame().
+    SContextObjects contextObjects;
+    bool lowLatency;         // See SSetLowLatency().
+    bool frameHidden;        // SBeginFrame() found the window hidden, draws are dropped until SEndFrame().
+    double frameStart;       // When SBeginFrame() sampled input, frameClock() seconds.
+    double renderTime;       // Running average from frameStart to the swap being submitted.
+    double lastShown;        // When the GPU finished the last frame.
+    SLatencyTracker latency;
+    SInputLog inputLog;      // See SRecordInput() and SReplayInput().
+} SApplication;
+
+// Globals of the compositor connection, shared by every window like the X11 display is.
+static struct {
+    struct wl_display *display;
+    struct wl_registry *registry;
+    struct wl_compositor *compositor;
+    struct xdg_wm_base *wmBase;
+    struct wp_viewporter *viewporter;
+    struct wl_seat *seat;
+    struct wl_pointer *pointer;
+    struct wl_keyboard *keyboard;
+    struct wl_output *output;
+    double refreshRate;      // From the current mode of the first output, 0 until known.
+    struct xkb_context *xkbContext;
+    struct xkb_keymap *keymap;
+    struct xkb_state *xkbState;
+    unsigned int modifiers;  // SMOD_* bits from the last wl_keyboard.modifiers.
+    EGLDisplay eglDisplay;
+    EGLConfig eglConfig;
+    SApplication *pointerFocus;
+    SApplication *keyboardFocus;
+    int users;
+} sharedWayland;
+
+static SApplication *stduiWindows[STDUI_MAX_WINDOWS];
+static int stduiWindowCount = 0;
+
+void SDisplayClose(SApplication *app);
+
+
+// Forward declarations from other files (widget.h and image.h)
+bool initText(const char* fontPath);
+bool SInitializeRenderer();
+void setOrthographicProjection(GLuint programID, int width, int height);
+void SGetContextObjects(SContextObjects* objects);
+void SUseContextObjects(const SContextObjects* objects);
+void SDeleteContextObjects(SContextObjects* objects);
+void SCleanupRenderer();
+void SCleanupTextRenderer();
+void releaseGlyphWake(SApplication *app);
+
+extern SRenderer renderer;
+
+
+static inline int SGetCurrentWindowWidth(SApplication *app) {
+    if (app == NULL || app->surface == NULL) {
+        return -1;
+    }
+    return app->width;
+}
+
+static inline int SGetCurrentWindowHeight(SApplication *app) {
+    if (app == NULL || app->surface == NULL) {
+        return -1;
+    }
+    return app->height;
+}
+
+
+void SGetMouseState(SApplication *app) {
+    if (app == NULL) {
+        return;
+    }
+
+    app->mouseX = app->input.mouseX;
+    app->mouseY = app->input.mouseY;
+    app->mouseDown = ((app->input.buttons | app->input.pressed) & 1) ? 1 : 0;
+}
+
+static SApplication* findSurfaceWindow(struct wl_surface *surface) {
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i]->surface == surface) {
+            return stduiWindows[i];
+        }
+    }
+    return NULL;
+}
+
+// Listeners run inside the dispatch of any window, so events go straight to their own window.
+static void deliverEvent(SApplication *app, SEvent *event) {
+    beginInput(&app->input);
+    if (event->time != 0 && event->type != SEVENT_CLOSE) {
+        noteInputTime(&app->latency, event->time);
+    }
+    recordEvent(&app->events, &app->input, event);
+    app->redraw = 1;
+}
+
+// Buffer size follows the surface size times renderScale, the viewport scales it back.
+static void applySurfaceSize(SApplication *app) {
+    if (app->eglWindow == NULL || app->width <= 0 || app->height <= 0) {
+        return;
+    }
+    wl_egl_window_resize(app->eglWindow, (int)(app->width * app->renderScale + 0.5f),
+                         (int)(app->height * app->renderScale + 0.5f), 0, 0);
+    if (app->viewport) {
+        wp_viewport_set_destination(app->viewport, app->width, app->height);
+    }
+    app->viewportWidth = app->viewportHeight = 0;
+}
+
+static void handleWmBasePing(void *data, struct xdg_wm_base *wmBase, uint32_t serial) {
+    (void)data;
+    xdg_wm_base_pong(wmBase, serial);
+}
+
+static const struct xdg_wm_base_listener wmBaseListener = {
+    .ping = handleWmBasePing
+};
+
+static void handleOutputGeometry(void *data, struct wl_output *output, int32_t x, int32_t y,
+                                 int32_t physicalWidth, int32_t physicalHeight, int32_t subpixel,
+                                 const char *make, const char *model, int32_t transform) {
+    (void)data; (void)output; (void)x; (void)y; (void)physicalWidth; (void)physicalHeight;
+    (void)subpixel; (void)make; (void)model; (void)transform;
+}
+
+static void handleOutputMode(void *data, struct wl_output *output, uint32_t flags,
+                             int32_t width, int32_t height, int32_t refresh) {
+    (void)data; (void)output; (void)width; (void)height;
+    if ((flags & WL_OUTPUT_MODE_CURRENT) && refresh > 0) {
+        sharedWayland.refreshRate = (double)refresh / 1000.0; // mHz
+    }
+}
+
+static void handleOutputDone(void *data, struct wl_output *output) {
+    (void)data; (void)output;
+}
+
+static void handleOutputScale(void *data, struct wl_output *output, int32_t factor) {
+    (void)data; (void)output; (void)factor;
+}
+
+static const struct wl_output_listener outputListener = {
+    .geometry = handleOutputGeometry,
+    .mode = handleOutputMode,
+    .done = handleOutputDone,
+    .scale = handleOutputScale
+};
+
+static void handlePointerEnter(void *data, struct wl_pointer *pointer, uint32_t serial,
+                               struct wl_surface *surface, wl_fixed_t x, wl_fixed_t y) {
+    (void)data; (void)pointer; (void)serial;
+    SApplication *app = findSurfaceWindow(surface);
+    sharedWayland.pointerFocus = app;
+    if (app) {
+        app->input.mouseX = (float)wl_fixed_to_double(x);
+        app->input.mouseY = (float)wl_fixed_to_double(y);
+    }
+}
+
+static void handlePointerLeave(void *data, struct wl_pointer *pointer, uint32_t serial,
+                               struct wl_surface *surface) {
+    (void)data; (void)pointer; (void)serial; (void)surface;
+    sharedWayland.pointerFocus = NULL;
+}
+
+static void handlePointerMotion(void *data, struct wl_pointer *pointer, uint32_t time,
+                                wl_fixed_t x, wl_fixed_t y) {
+    (void)data; (void)pointer;
+    SApplication *app = sharedWayland.pointerFocus;
+    if (app == NULL) {
+        return;
+    }
+
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = SEVENT_MOTION;
+    event.x = (float)wl_fixed_to_double(x);
+    event.y = (float)wl_fixed_to_double(y);
+    event.modifiers = sharedWayland.modifiers;
+    event.time = time;
+    deliverEvent(app, &event);
+}
+
+static void handlePointerButton(void *data, struct wl_pointer *pointer, uint32_t serial,
+                                uint32_t time, uint32_t button, uint32_t state) {
+    (void)data; (void)pointer; (void)serial;
+    SApplication *app = sharedWayland.pointerFocus;
+    if (app == NULL) {
+        return;
+    }
+
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    // Same numbering as X11 after translateButton: 4 and 5 are back and forward.
+    switch (button) {
+        case BTN_LEFT:   event.button = 1; break;
+        case BTN_MIDDLE: event.button = 2; break;
+        case BTN_RIGHT:  event.button = 3; break;
+        case BTN_SIDE:   event.button = 4; break;
+        case BTN_EXTRA:  event.button = 5; break;
+        default: return;
+    }
+    event.type = state == WL_POINTER_BUTTON_STATE_PRESSED ? SEVENT_BUTTON_PRESS : SEVENT_BUTTON_RELEASE;
+    event.x = app->input.mouseX;
+    event.y = app->input.mouseY;
+    event.modifiers = sharedWayland.modifiers;
+    event.time = time;
+    deliverEvent(app, &event);
+}
+
+static void handlePointerAxis(void *data, struct wl_pointer *pointer, uint32_t time,
+                              uint32_t axis, wl_fixed_t value) {
+    (void)data; (void)pointer;
+    SApplication *app = sharedWayland.pointerFocus;
+    if (app == NULL) {
+        return;
+    }
+
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    // Axis values are in surface units, a wheel step is 10 of them. Wayland counts down as positive.
+    float steps = (float)(wl_fixed_to_double(value) / 10.0);
+    event.type = SEVENT_SCROLL;
+    event.x = app->input.mouseX;
+    event.y = app->input.mouseY;
+    if (axis == WL_POINTER_AXIS_VERTICAL_SCROLL) {
+        event.scrollY = -steps;
+    } else {
+        event.scrollX = steps;
+    }
+    event.modifiers = sharedWayland.modifiers;
+    event.time = time;
+    deliverEvent(app, &event);
+}
+
+// Bound at version 4, the pointer frame and axis detail events of version 5 are never sent.
+static const struct wl_pointer_listener pointerListener = {
+    .enter = handlePointerEnter,
+    .leave = handlePointerLeave,
+    .motion = handlePointerMotion,
+    .button = handlePointerButton,
+    .axis = handlePointerAxis
+};
+
+static void handleKeyboardKeymap(void *data, struct wl_keyboard *keyboard, uint32_t format,
+                                 int32_t fd, uint32_t size) {
+    (void)data; (void)keyboard;
+    if (format != WL_KEYBOARD_KEYMAP_FORMAT_XKB_V1) {
+        close(fd);
+        return;
+    }
+
+    char *text = (char*)mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (text == MAP_FAILED) {
+        fprintf(stderr, "ERROR: Could not map the Wayland keymap.\n");
+        return;
+    }
+    struct xkb_keymap *keymap = xkb_keymap_new_from_string(sharedWayland.xkbContext, text,
+                                                           XKB_KEYMAP_FORMAT_TEXT_V1, XKB_KEYMAP_COMPILE_NO_FLAGS);
+    munmap(text, size);
+    if (keymap == NULL) {
+        fprintf(stderr, "ERROR: Could not compile the Wayland keymap.\n");
+        return;
+    }
+
+    xkb_state_unref(sharedWayland.xkbState);
+    xkb_keymap_unref(sharedWayland.keymap);
+    sharedWayland.keymap = keymap;
+    sharedWayland.xkbState = xkb_state_new(keymap);
+}
+
+static void handleKeyboardEnter(void *data, struct wl_keyboard *keyboard, uint32_t serial,
+                                struct wl_surface *surface, struct wl_array *keys) {
+    (void)data; (void)keyboard; (void)serial; (void)keys;
+    SApplication *app = findSurfaceWindow(surface);
+    sharedWayland.keyboardFocus = app;
+    if (app) {
+        SEvent event;
+        memset(&event, 0, sizeof(event));
+        event.type = SEVENT_FOCUS_IN;
+        deliverEvent(app, &event);
+    }
+}
+
+static void handleKeyboardLeave(void *data, struct wl_keyboard *keyboard, uint32_t serial,
+                                struct wl_surface *surface) {
+    (void)data; (void)keyboard; (void)serial;
+    SApplication *app = findSurfaceWindow(surface);
+    sharedWayland.keyboardFocus = NULL;
+    if (app) {
+        SEvent event;
+        memset(&event, 0, sizeof(event));
+        event.type = SEVENT_FOCUS_OUT;
+        deliverEvent(app, &event);
+    }
+}
+
+static void handleKeyboardKey(void *data, struct wl_keyboard *keyboard, uint32_t serial,
+                              uint32_t time, uint32_t key, uint32_t state) {
+    (void)data; (void)keyboard; (void)serial;
+    SApplication *app = sharedWayland.keyboardFocus;
+    if (app == NULL || sharedWayland.keymap == NULL) {
+        return;
+    }
+
+    // Unshifted keysym like XLookupKeysym(event, 0) on X11, evdev codes are 8 below XKB's.
+    const xkb_keysym_t *syms = NULL;
+    int count = xkb_keymap_key_get_syms_by_level(sharedWayland.keymap, key + 8, 0, 0, &syms);
+
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = state == WL_KEYBOARD_KEY_STATE_PRESSED ? SEVENT_KEY_PRESS : SEVENT_KEY_RELEASE;
+    event.key = count > 0 ? (unsigned int)syms[0] : 0;
+    event.modifiers = sharedWayland.modifiers;
+    event.time = time;
+    deliverEvent(app, &event);
+
+    if (event.type == SEVENT_KEY_PRESS && event.key == XKB_KEY_Escape) {
+        app->input.closeRequested = true;
+    }
+}
+
+static void handleKeyboardModifiers(void *data, struct wl_keyboard *keyboard, uint32_t serial,
+                                    uint32_t depressed, uint32_t latched, uint32_t locked, uint32_t group) {
+    (void)data; (void)keyboard; (void)serial;
+    struct xkb_state *state = sharedWayland.xkbState;
+    if (state == NULL) {
+        return;
+    }
+    xkb_state_update_mask(state, depressed, latched, locked, 0, 0, group);
+
+    unsigned int modifiers = 0;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_SHIFT, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_SHIFT;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_CTRL, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_CONTROL;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_ALT, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_ALT;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_LOGO, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_SUPER;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_CAPS, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_CAPS_LOCK;
+    if (xkb_state_mod_name_is_active(state, XKB_MOD_NAME_NUM, XKB_STATE_MODS_EFFECTIVE) > 0) modifiers |= SMOD_NUM_LOCK;
+    sharedWayland.modifiers = modifiers;
+}
+
+static void handleKeyboardRepeatInfo(void *data, struct wl_keyboard *keyboard, int32_t rate, int32_t delay) {
+    (void)data; (void)keyboard; (void)rate; (void)delay;
+}
+
+static const struct wl_keyboard_listener keyboardListener = {
+    .keymap = handleKeyboardKeymap,
+    .enter = handleKeyboardEnter,
+    .leave = handleKeyboardLeave,
+    .key = handleKeyboardKey,
+    .modifiers = handleKeyboardModifiers,
+    .repeat_info = handleKeyboardRepeatInfo
+};
+
+static void handleSeatCapabilities(void *data, struct wl_seat *seat, uint32_t capabilities) {
+    (void)data;
+    if ((capabilities & WL_SEAT_CAPABILITY_POINTER) && sharedWayland.pointer == NULL) {
+        sharedWayland.pointer = wl_seat_get_pointer(seat);
+        wl_pointer_add_listener(sharedWayland.pointer, &pointerListener, NULL);
+    } else if (!(capabilities & WL_SEAT_CAPABILITY_POINTER) && sharedWayland.pointer) {
+        wl_pointer_destroy(sharedWayland.pointer);
+        sharedWayland.pointer = NULL;
+        sharedWayland.pointerFocus = NULL;
+    }
+
+    if ((capabilities & WL_SEAT_CAPABILITY_KEYBOARD) && sharedWayland.keyboard == NULL) {
+        sharedWayland.keyboard = wl_seat_get_keyboard(seat);
+        wl_keyboard_add_listener(sharedWayland.keyboard, &keyboardListener, NULL);
+    } else if (!(capabilities & WL_SEAT_CAPABILITY_KEYBOARD) && sharedWayland.keyboard) {
+        wl_keyboard_destroy(sharedWayland.keyboard);
+        sharedWayland.keyboard = NULL;
+        sharedWayland.keyboardFocus = NULL;
+    }
+}
+
+static void handleSeatName(void *data, struct wl_seat *seat, const char *name) {
+    (void)data; (void)seat; (void)name;
+}
+
+static const struct wl_seat_listener seatListener = {
+    .capabilities = handleSeatCapabilities,
+    .name = handleSeatName
+};
+
+static void handleRegistryGlobal(void *data, struct wl_registry *registry, uint32_t name,
+                                 const char *interface, uint32_t version) {
+    (void)data;
+    if (strcmp(interface, wl_compositor_interface.name) == 0) {
+        sharedWayland.compositor = (struct wl_compositor*)
+            wl_registry_bind(registry, name, &wl_compositor_interface, version < 4 ? version : 4);
+    } else if (strcmp(interface, xdg_wm_base_interface.name) == 0) {
+        sharedWayland.wmBase = (struct xdg_wm_base*) wl_registry_bind(registry, name, &xdg_wm_base_interface, 1);
+        xdg_wm_base_add_listener(sharedWayland.wmBase, &wmBaseListener, NULL);
+    } else if (strcmp(interface, wl_seat_interface.name) == 0 && sharedWayland.seat == NULL) {
+        sharedWayland.seat = (struct wl_seat*)
+            wl_registry_bind(registry, name, &wl_seat_interface, version < 4 ? version : 4);
+        wl_seat_add_listener(sharedWayland.seat, &seatListener, NULL);
+    } else if (strcmp(interface, wp_viewporter_interface.name) == 0) {
+        sharedWayland.viewporter = (struct wp_viewporter*) wl_registry_bind(registry, name, &wp_viewporter_interface, 1);
+    } else if (strcmp(interface, wl_output_interface.name) == 0 && sharedWayland.output == NULL) {
+        sharedWayland.output = (struct wl_output*)
+            wl_registry_bind(registry, name, &wl_output_interface, version < 2 ? version : 2);
+        wl_output_add_listener(sharedWayland.output, &outputListener, NULL);
+    }
+}
+
+static void handleRegistryGlobalRemove(void *data, struct wl_registry *registry, uint32_t name) {
+    (void)data; (void)registry; (void)name;
+}
+
+static const struct wl_registry_listener registryListener = {
+    .global = handleRegistryGlobal,
+    .global_remove = handleRegistryGlobalRemove
+};
+
+static void handleXdgSurfaceConfigure(void *data, struct xdg_surface *xdgSurface, uint32_t serial) {
+    SApplication *app = (SApplication*)data;
+    xdg_surface_ack_configure(xdgSurface, serial);
+    app->configured = true;
+    applySurfaceSize(app);
+    app->redraw = 1;
+}
+
+static const struct xdg_surface_listener xdgSurfaceListener = {
+    .configure = handleXdgSurfaceConfigure
+};
+
+static void handleToplevelConfigure(void *data, struct xdg_toplevel *toplevel, int32_t width, int32_t height,
+                                    struct wl_array *states) {
+    (void)toplevel; (void)states;
+    SApplication *app = (SApplication*)data;
+    // 0 leaves the size to us, keep the current one.
+    if (width <= 0 || height <= 0 || (width == app->width && height == app->height)) {
+        return;
+    }
+
+    app->width = width;
+    app->height = height;
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = SEVENT_RESIZE;
+    event.width = width;
+    event.height = height;
+    deliverEvent(app, &event);
+}
+
+static void handleToplevelClose(void *data, struct xdg_toplevel *toplevel) {
+    (void)toplevel;
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    event.type = SEVENT_CLOSE;
+    deliverEvent((SApplication*)data, &event);
+}
+
+static const struct xdg_toplevel_listener toplevelListener = {
+    .configure = handleToplevelConfigure,
+    .close = handleToplevelClose
+};
+
+// Wayland has no visibility events, but the compositor sends no frame callbacks for a surface it
+// does not show: minimized, on another workspace or fully covered. One that is 100 ms late,
+// the cap of waitForFrameCallback(), means the window is hidden.
+static bool windowHidden(SApplication *app) {
+    return app->frameCallback != NULL && frameClock() - app->frameRequested >= 0.1;
+}
+
+static void handleFrameDone(void *data, struct wl_callback *callback, uint32_t time) {
+    (void)time;
+    SApplication *app = (SApplication*)data;
+    if (windowHidden(app)) {
+        app->redraw = 1; // Shown again, the frames since were not drawn.
+    }
+    wl_callback_destroy(callback);
+    app->frameCallback = NULL;
+}
+
+static const struct wl_callback_listener frameListener = {
+    .done = handleFrameDone
+};
+
+// Read what the compositor sent within timeout seconds (negative waits forever, 0 only takes
+// what is there) and dispatch it. Also returns when wakeFd becomes readable, pass -1 for none.
+// Returns the poll() result: 0 when the timeout passed, negative when the connection failed.
+static int pumpWayland(int wakeFd, double timeout) {
+    struct wl_display *display = sharedWayland.display;
+    while (wl_display_prepare_read(display) != 0) {
+        if (wl_display_dispatch_pending(display) < 0) {
+            return -1;
+        }
+    }
+    // A full socket is retried by the next flush, the server is still reading.
+    if (wl_display_flush(display) < 0 && errno != EAGAIN) {
+        wl_display_cancel_read(display);
+        return -1;
+    }
+
+    struct pollfd fds[2] = {
+        { wl_display_get_fd(display), POLLIN, 0 },
+        { wakeFd, POLLIN, 0 }
+    };
+    int timeoutMs = timeout < 0.0 ? -1 : (int)(timeout * 1000.0 + 0.5);
+    int ready;
+    do {
+        ready = poll(fds, wakeFd >= 0 ? 2 : 1, timeoutMs);
+    } while (ready < 0 && errno == EINTR);
+
+    if (ready > 0 && (fds[0].revents & POLLIN)) {
+        if (wl_display_read_events(display) < 0) {
+            return -1;
+        }
+    } else {
+        wl_display_cancel_read(display);
+    }
+
+    if (wakeFd >= 0 && ready > 0 && (fds[1].revents & POLLIN)) {
+        uint64_t count;
+        if (read(wakeFd, &count, sizeof(count)) < 0) {
+            // Nothing to clear, another wait already read it.
+        }
+    }
+
+    if (wl_display_dispatch_pending(display) < 0) {
+        return -1;
+    }
+    return ready;
+}
+
+// Frame callbacks pace drawing, 0 draws as fast as possible. -1 (adaptive) counts as 1, a late
+// frame never waits on Wayland anyway.
+bool SSetSwapInterval(SApplication *app, int interval) {
+    if (app == NULL) {
+        return false;
+    }
+    app->swapInterval = interval < 0 ? 1 : interval;
+    return true;
+}
+
+// Render at scale times the surface size and let the compositor scale it to the window through
+// wp_viewporter. Below 1 saves fill rate on slow GPUs, above 1 supersamples.
+bool SSetRenderScale(SApplication *app, float scale) {
+    if (app == NULL || app->viewport == NULL || scale <= 0.0f) {
+        return false;
+    }
+    app->renderScale = scale;
+    applySurfaceSize(app);
+    return true;
+}
+
+// Release whatever part of the shared connection exists, also after a failed SDisplayOpen().
+static void closeSharedWayland(void) {
+    if (sharedWayland.eglDisplay != EGL_NO_DISPLAY) {
+        eglTerminate(sharedWayland.eglDisplay);
+    }
+    if (sharedWayland.xkbState) xkb_state_unref(sharedWayland.xkbState);
+    if (sharedWayland.keymap) xkb_keymap_unref(sharedWayland.keymap);
+    if (sharedWayland.xkbContext) xkb_context_unref(sharedWayland.xkbContext);
+    if (sharedWayland.pointer) wl_pointer_destroy(sharedWayland.pointer);
+    if (sharedWayland.keyboard) wl_keyboard_destroy(sharedWayland.keyboard);
+    if (sharedWayland.seat) wl_seat_destroy(sharedWayland.seat);
+    if (sharedWayland.output) wl_output_destroy(sharedWayland.output);
+    if (sharedWayland.viewporter) wp_viewporter_destroy(sharedWayland.viewporter);
+    if (sharedWayland.wmBase) xdg_wm_base_destroy(sharedWayland.wmBase);
+    if (sharedWayland.compositor) wl_compositor_destroy(sharedWayland.compositor);
+    if (sharedWayland.registry) wl_registry_destroy(sharedWayland.registry);
+    if (sharedWayland.display) wl_display_disconnect(sharedWayland.display);
+    memset(&sharedWayland, 0, sizeof(sharedWayland));
+}
+
+int SDisplayOpen(SApplication *app) {
+    if (app == NULL) {
+        return 0;
+    }
+    // Applications keep this on the stack, state that no window sets up has to start out zero.
+    memset(app, 0, sizeof(*app));
+    app->wakeFd = -1;
+    if (sharedWayland.display == NULL) {
+        sharedWayland.display = wl_display_connect(NULL);
+        if (sharedWayland.display == NULL) {
+            fprintf(stderr, "ERROR: Unable to connect to the Wayland compositor.\n");
+            return 0;
+        }
+
+        sharedWayland.xkbContext = xkb_context_new(XKB_CONTEXT_NO_FLAGS);
+        sharedWayland.registry = wl_display_get_registry(sharedWayland.display);
+        wl_registry_add_listener(sharedWayland.registry, &registryListener, NULL);
+        // The first round trip lists the globals, the second brings the seat, keymap and output mode.
+        wl_display_roundtrip(sharedWayland.display);
+        wl_display_roundtrip(sharedWayland.display);
+        if (sharedWayland.compositor == NULL || sharedWayland.wmBase == NULL) {
+            fprintf(stderr, "ERROR: The Wayland compositor has no wl_compositor or xdg_wm_base.\n");
+            closeSharedWayland();
+            return 0;
+        }
+
+        static const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+            EGL_RENDERABLE_TYPE, STDUI_EGL_RENDERABLE_TYPE,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLint configCount = 0;
+        sharedWayland.eglDisplay = eglGetDisplay((EGLNativeDisplayType)sharedWayland.display);
+        if (sharedWayland.eglDisplay == EGL_NO_DISPLAY || !eglInitialize(sharedWayland.eglDisplay, NULL, NULL) ||
+            !eglBindAPI(STDUI_EGL_API) ||
+            !eglChooseConfig(sharedWayland.eglDisplay, configAttribs, &sharedWayland.eglConfig, 1, &configCount) ||
+            configCount == 0) {
+            fprintf(stderr, "ERROR: No EGL config for " STDUI_EGL_API_NAME " on this Wayland display.\n");
+            closeSharedWayland();
+            return 0;
+        }
+        #ifdef STDUI_VERBAL_DEBUG
+        printf("STATUS: Connected to the Wayland compositor. \n");
+        #endif
+    }
+    app->display = sharedWayland.display;
+    sharedWayland.users++;
+    return 1;
+}
+
+// The first GL context joins no group, later ones share with it.
+static EGLContext shareGroupContext(void) {
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i]->eglContext != EGL_NO_CONTEXT) {
+            return stduiWindows[i]->eglContext;
+        }
+    }
+    return EGL_NO_CONTEXT;
+}
+
+// x and y are ignored, Wayland clients do not place their toplevels.
+int SWindowCreate(SApplication *app, const char *title, int x, int y, int width, int height) {
+    (void)x; (void)y; // xdg-shell leaves placement to the compositor
+    if (app == NULL || app->display == NULL) {
+        return 0;
+    }
+
+    if (stduiWindowCount >= STDUI_MAX_WINDOWS) {
+        fprintf(stderr, "ERROR: Too many windows (max %d)\n", STDUI_MAX_WINDOWS);
+        return 0;
+    }
+
+    memset(&app->events, 0, sizeof(app->events));
+    memset(&app->inputLog, 0, sizeof(app->inputLog));
+    memset(&app->input, 0, sizeof(app->input));
+    memset(&app->contextObjects, 0, sizeof(app->contextObjects));
+    app->width = width;
+    app->height = height;
+    app->viewportWidth = app->viewportHeight = 0; // Set up by the first SBeginFrame().
+    app->renderScale = 1.0f;
+    app->configured = false;
+    app->frameCallback = NULL;
+    app->eglWindow = NULL;
+    app->eglSurface = EGL_NO_SURFACE;
+    app->eglContext = EGL_NO_CONTEXT;
+    app->redraw = 1;
+    app->frameHidden = false;
+
+    app->surface = wl_compositor_create_surface(sharedWayland.compositor);
+    app->xdgSurface = xdg_wm_base_get_xdg_surface(sharedWayland.wmBase, app->surface);
+    xdg_surface_add_listener(app->xdgSurface, &xdgSurfaceListener, app);
+    app->toplevel = xdg_surface_get_toplevel(app->xdgSurface);
+    xdg_toplevel_add_listener(app->toplevel, &toplevelListener, app);
+    xdg_toplevel_set_title(app->toplevel, title);
+    app->viewport = sharedWayland.viewporter ? wp_viewporter_get_viewport(sharedWayland.viewporter, app->surface) : NULL;
+    stduiWindows[stduiWindowCount++] = app;
+
+    // Commit without a buffer and wait for the first configure, it may change the size.
+    wl_surface_commit(app->surface);
+    while (!app->configured) {
+        if (wl_display_dispatch(app->display) < 0) {
+            fprintf(stderr, "ERROR: The Wayland compositor never configured the window.\n");
+            SDisplayClose(app);
+            return 0;
+        }
+    }
+
+    // Other threads wake the event loop through this, see SPostEmptyEvent().
+    app->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (app->wakeFd < 0) {
+        fprintf(stderr, "ERROR: Failed to create wake up eventfd, SPostEmptyEvent() will not wake the loop.\n");
+    }
+
+    static const EGLint contextAttribs[] = { STDUI_EGL_CONTEXT_ATTRIBS };
+    app->eglWindow = wl_egl_window_create(app->surface, app->width, app->height);
+    app->eglSurface = eglCreateWindowSurface(sharedWayland.eglDisplay, sharedWayland.eglConfig,
+                                             (EGLNativeWindowType)app->eglWindow, NULL);
+    app->eglContext = eglCreateContext(sharedWayland.eglDisplay, sharedWayland.eglConfig,
+                                       shareGroupContext(), contextAttribs);
+    if (app->eglSurface == EGL_NO_SURFACE || app->eglContext == EGL_NO_CONTEXT) {
+        fprintf(stderr, "ERROR: Failed to create OpenGL context.\n");
+        SDisplayClose(app);
+        return 0;
+    }
+
+    if (!eglMakeCurrent(sharedWayland.eglDisplay, app->eglSurface, app->eglSurface, app->eglContext)) {
+        fprintf(stderr, "ERROR: Failed to make context current.\n");
+        SDisplayClose(app);
+        return 0;
+    }
+    applySurfaceSize(app);
+
+    // Frame callbacks pace drawing, EGL must not block in eglSwapBuffers() on its own.
+    eglSwapInterval(sharedWayland.eglDisplay, 0);
+    SSetSwapInterval(app, 1);
+    initFramePacer(&app->pacer, sharedWayland.refreshRate > 0.0 ? sharedWayland.refreshRate : 60.0);
+
+    // Enable blending for text.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Initialize renderer, only the first window creates the shared objects.
+    if (!SInitializeRenderer()) {
+        fprintf(stderr, "ERROR: Failed to initialize rendering.\n");
+        SDisplayClose(app);
+        return 0;
+    }
+
+    // Initialize text rendering.
+    if (!initText(NULL)) {
+        fprintf(stderr, "ERROR: Failed to initialize text rendering.\n");
+        SDisplayClose(app);
+        return 0;
+    }
+
+    SGetContextObjects(&app->contextObjects);
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Window created with code 0: \n OpenGL version: %s\n GLSL version: %s \n",
+           (const char*)glGetString(GL_VERSION), (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION));
+    #endif
+
+    wl_display_flush(app->display);
+    return 1;
+}
+
+// Dispatch everything the compositor sent so far. Returns 0 once this window was closed or
+// Escape pressed in it.
+int SEventProcess(SApplication *app) {
+    if (app == NULL || app->display == NULL) {
+        return 0;
+    }
+
+    beginInput(&app->input);
+    if (pumpWayland(-1, 0.0) < 0) {
+        fprintf(stderr, "ERROR: Lost the connection to the Wayland compositor.\n");
+        app->input.closeRequested = true;
+    }
+    if (advanceInputLog(&app->events, &app->input)) {
+        app->redraw = 1;
+    }
+    SGetMouseState(app);
+    app->input.delivered = true;
+    return !app->input.closeRequested;
+}
+
+// Sleep until the compositor sends something, SPostEmptyEvent() is called or timeout seconds
+// pass (negative waits forever), then dispatch like SEventProcess(). A timeout requests a redraw.
+// Glyph workers wake the window that last drew text, see SGetPendingGlyphCount().
+int SWaitEvents(SApplication *app, double timeout) {
+    if (app == NULL || app->display == NULL) {
+        return 0;
+    }
+
+    // A replay runs flat out, every call is one frame of the log.
+    if (app->inputLog.replaying) {
+        app->redraw = 1;
+    }
+
+    if (!app->redraw) {
+        beginInput(&app->input);
+        if (windowHidden(app)) {
+            timeout = hiddenWaitTimeout(timeout);
+        }
+        if (pumpWayland(app->wakeFd, timeout) == 0) {
+            app->redraw = 1;
+        }
+    }
+
+    return SEventProcess(app);
+}
+
+// Wake a thread blocked in SWaitEvents(). Safe to call from any thread.
+void SPostEmptyEvent(SApplication *app) {
+    if (app == NULL || app->wakeFd < 0) {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(app->wakeFd, &one, sizeof(one)) < 0) {
+        // The counter is already non-zero, the loop wakes up anyway.
+    }
+}
+
+void SDisplayClose(SApplication *app) {
+    if (app == NULL) {
+        return;
+    }
+    closeInputLog(&app->events);
+    releaseGlyphWake(app);
+
+    int index = -1;
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i] == app) {
+            index = i;
+        }
+    }
+
+    if (app->eglContext != EGL_NO_CONTEXT) {
+        eglMakeCurrent(sharedWayland.eglDisplay, app->eglSurface, app->eglSurface, app->eglContext);
+        SDeleteContextObjects(&app->contextObjects);
+        // The shared objects go with the last context of the group.
+        if (index >= 0 && stduiWindowCount == 1) {
+            SCleanupTextRenderer();
+            SCleanupRenderer();
+        }
+        eglMakeCurrent(sharedWayland.eglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext(sharedWayland.eglDisplay, app->eglContext);
+        app->eglContext = EGL_NO_CONTEXT;
+    }
+
+    if (index >= 0) {
+        stduiWindows[index] = stduiWindows[--stduiWindowCount];
+        stduiWindows[stduiWindowCount] = NULL;
+    }
+    if (sharedWayland.pointerFocus == app) {
+        sharedWayland.pointerFocus = NULL;
+    }
+    if (sharedWayland.keyboardFocus == app) {
+        sharedWayland.keyboardFocus = NULL;
+    }
+
+    if (app->frameCallback) {
+        wl_callback_destroy(app->frameCallback);
+        app->frameCallback = NULL;
+    }
+    if (app->eglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(sharedWayland.eglDisplay, app->eglSurface);
+        app->eglSurface = EGL_NO_SURFACE;
+    }
+    if (app->eglWindow) {
+        wl_egl_window_destroy(app->eglWindow);
+        app->eglWindow = NULL;
+    }
+    if (app->viewport) {
+        wp_viewport_destroy(app->viewport);
+        app->viewport = NULL;
+    }
+    if (app->toplevel) {
+        xdg_toplevel_destroy(app->toplevel);
+        app->toplevel = NULL;
+    }
+    if (app->xdgSurface) {
+        xdg_surface_destroy(app->xdgSurface);
+        app->xdgSurface = NULL;
+    }
+    if (app->surface) {
+        wl_surface_destroy(app->surface);
+        app->surface = NULL;
+    }
+
+    if (app->wakeFd >= 0) {
+        close(app->wakeFd);
+        app->wakeFd = -1;
+    }
+
+    if (app->display) {
+        if (--sharedWayland.users == 0) {
+            closeSharedWayland();
+        }
+        app->display = NULL;
+    }
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Cleanup completed with code 0.\n");
+    #endif
+}
+
+static inline void SClearScreen(SApplication *app, float r, float g, float b) {
+    (void)app;
+    glClearColor(r, g, b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+// width and height are in surface units, the buffer has renderScale times as many pixels.
+void SUpdateViewport(SApplication *app, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return; // Avoid setting invalid viewport dimensions
+    }
+    glViewport(0, 0, (int)(width * app->renderScale + 0.5f), (int)(height * app->renderScale + 0.5f));
+}
+
+// Update the viewport and the shape projection when the window size changed since the last frame.
+static inline void applyWindowSize(SApplication *app) {
+    if (app->width <= 0 || app->height <= 0 ||
+        (app->width == app->viewportWidth && app->height == app->viewportHeight)) {
+        return;
+    }
+
+    SUpdateViewport(app, app->width, app->height);
+    glUseProgram(renderer.basicProgram);
+    setOrthographicProjection(renderer.basicProgram, app->width, app->height);
+    app->viewportWidth = app->width;
+    app->viewportHeight = app->height;
+}
+
+// Make this window's context current and point the draw functions at its objects.
+void SMakeCurrent(SApplication *app) {
+    if (app == NULL || app->eglContext == EGL_NO_CONTEXT) {
+        return;
+    }
+    eglMakeCurrent(sharedWayland.eglDisplay, app->eglSurface, app->eglSurface, app->eglContext);
+    SUseContextObjects(&app->contextObjects);
+    app->viewportWidth = app->viewportHeight = 0;
+}
+
+// Low-latency mode, see the X11 version. The frame counts as shown once the GPU finished it.
+bool SSetLowLatency(SApplication *app, bool enable) {
+    if (app == NULL || app->surface == NULL) {
+        return false;
+    }
+    app->lowLatency = enable;
+    app->renderTime = 0.0;
+    app->lastShown = 0.0;
+    app->latency.pendingInput = 0.0;
+    return true;
+}
+
+static void sampleInputLate(SApplication *app) {
+    if (app->swapInterval != 0) {
+        waitForLateStart(app->lastShown, app->pacer.refreshRate, app->renderTime);
+    }
+
+    app->frameStart = frameClock();
+    bool delivered = app->input.delivered;
+    app->input.delivered = false;
+    setLateSample(&app->events, true);
+    pumpWayland(-1, 0.0);
+    setLateSample(&app->events, false);
+    app->input.delivered = delivered;
+    SGetMouseState(app);
+}
+
+static void finishLowLatencyFrame(SApplication *app, double submitted) {
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+        glDeleteSync(fence);
+    }
+
+    app->renderTime = averageRenderTime(app->renderTime, submitted - app->frameStart);
+    app->lastShown = frameClock();
+    recordLatency(&app->latency, app->lastShown);
+}
+
+// Wait until the compositor asks for the next frame. Hidden surfaces get no frame callbacks, so
+// this gives up after 100 ms instead of stalling the loop.
+static void waitForFrameCallback(SApplication *app) {
+    double deadline = frameClock() + 0.1;
+    while (app->frameCallback != NULL) {
+        double left = deadline - frameClock();
+        if (left <= 0.0 || pumpWayland(-1, left) <= 0) {
+            break;
+        }
+    }
+}
+
+// Start a frame. Returns false when the window is hidden: the draw functions do nothing until
+// SEndFrame(), which ticks at STDUI_HIDDEN_FRAME_RATE, so only the app state needs updating.
+static inline bool SBeginFrame(SApplication *app) {
+    if (app == NULL || app->display == NULL) {
+        return false;
+    }
+
+    if (eglGetCurrentContext() != app->eglContext) {
+        SMakeCurrent(app);
+    }
+
+    if (app->swapInterval != 0) {
+        waitForFrameCallback(app);
+    }
+    app->frameHidden = windowHidden(app);
+    if (app->lowLatency && !app->frameHidden) {
+        sampleInputLate(app);
+    }
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Entering Rendering Loop \n");
+    #endif
+
+    // Cleared before drawing, so an SInvalidate() during the frame asks for another one.
+    app->redraw = 0;
+    if (app->frameHidden) {
+        return false;
+    }
+
+    applyWindowSize(app);
+
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    return true;
+}
+
+static inline void SEndFrame(SApplication *app) {
+    if (app == NULL || app->eglSurface == EGL_NO_SURFACE) {
+        return;
+    }
+
+    // Nothing was drawn, keep the last commit and its pending frame callback.
+    if (app->frameHidden) {
+        app->frameHidden = false;
+        paceHiddenFrame(&app->pacer);
+        return;
+    }
+
+    // Asked for before the swap, eglSwapBuffers() commits the surface with the request.
+    if (app->frameCallback == NULL) {
+        app->frameCallback = wl_surface_frame(app->surface);
+        app->frameRequested = frameClock();
+        wl_callback_add_listener(app->frameCallback, &frameListener, app);
+    }
+
+    double submitted = frameClock();
+    eglSwapBuffers(sharedWayland.eglDisplay, app->eglSurface);
+    if (app->lowLatency) {
+        finishLowLatencyFrame(app, submitted);
+    }
+    paceFrame(&app->pacer);
+}
+
+#elif defined(__linux__)
+
+#include <X11/Xlib.h>
+#include <X11/Xatom.h>
+#include <X11/keysym.h>
+#ifdef STDUI_GLES
+#include <X11/Xutil.h>
+#include <EGL/egl.h>
+#else
+#include <GL/glx.h>
+#endif
+#include <errno.h>
+#include <poll.h>
+#include <stdint.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <time.h>
+
+// XInput2 gives subpixel pointer positions, link with -lXi when enabling it.
+#ifdef STDUI_XINPUT2
+#include <X11/extensions/XInput2.h>
+#endif
+
+// Read the refresh rate of the monitor the window is on from XRandR, link with -lXrandr.
+// Without it the rate comes from GLX_OML_sync_control.
+#ifdef STDUI_XRANDR
+#include <X11/extensions/Xrandr.h>
+#endif
+
+// Present software frames from MIT-SHM shared memory, link with -lXext. Without it software
+// windows are copied through the X socket.
+#ifdef STDUI_XSHM
+#ifdef STDUI_USE_XCB
+#error "STDUI_XSHM waits for completion events through Xlib and does not work with STDUI_USE_XCB."
+#endif
+#include <X11/extensions/XShm.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#endif
+
+// Create windows and read events through XCB instead of Xlib, link with -lxcb -lX11-xcb. GLX still
+// needs the Xlib Display, both share one connection. Requests go out without waiting for replies
+// and events are read in batches without blocking.
+#ifdef STDUI_USE_XCB
+#ifdef STDUI_XINPUT2
+#error "STDUI_XINPUT2 reads events through Xlib and does not work with STDUI_USE_XCB."
+#endif
+#include <xcb/xcb.h>
+#include <xcb/xcbext.h> // xcb_poll_for_reply()
+#include <X11/Xlib-xcb.h>
+#include <X11/XKBlib.h>
+#endif
+#ifdef STDUI_GLES
+#include <GLES3/gl3.h>
+#else
+#include <GL/glxext.h>
+#include <GL/gl.h>
+#endif
+#include "internal/gl_loader.h"
+
+// One of the two CPU framebuffers of a software window.
+typedef struct {
+    XImage *image;
+#ifdef STDUI_XSHM
+    XShmSegmentInfo shm;
+#endif
+    bool shared;             // In MIT-SHM memory, presented without copying through the socket.
+    bool busy;               // The server still reads it, until its ShmCompletion event arrives.
+} SSoftwareBuffer;
+
+// Pixels to draw a software frame into, 0xAARRGGBB with the top row first. Alpha is ignored.
+typedef struct {
+    unsigned int *pixels;
+    int width, height;
+    int stride;              // Pixels per row.
+} SFramebuffer;
+
+typedef struct {
+    Display *display;
+    int screen;
+    Window window;
+    XEvent event;
+#ifdef STDUI_GLES
+    EGLSurface eglSurface;
+    EGLContext eglContext;
+#else
+    GLXContext glx_context;
+#endif
+    Colormap colormap;
+    float mouseX;
+    float mouseY;
+    int mouseDown;
+    Atom wmDeleteWindow;
+    Atom netWmState, netWmStateHidden;
+    int width, height;       // Last size reported by ConfigureNotify.
+    int viewportWidth, viewportHeight; // Size the viewport and projection were last set for.
+    SEventQueue events;
+    SInputState input;
+    int wakeFd;              // eventfd written by SPostEmptyEvent() to wake SWaitEvents().
+    int xiOpcode;            // XInput2 major opcode, 0 when pointer events come from the core protocol.
+    int swapInterval;        // Last interval accepted by SSetSwapInterval().
+    SFramePacer pacer;
+    volatile int redraw;     // Set by input, SWaitEvents() timeouts and SInvalidate(), cleared by SBeginFrame().
+    SContextObjects contextObjects;
+    bool lowLatency;         // See SSetLowLatency().
+    bool mapped;             // Between MapNotify and UnmapNotify.
+    bool obscured;           // The last VisibilityNotify was VisibilityFullyObscured.
+    bool minimized;          // _NET_WM_STATE lists _NET_WM_STATE_HIDDEN.
+    bool stateChanged;       // _NET_WM_STATE changed since minimized was last updated.
+    bool frameHidden;        // SBeginFrame() found the window hidden, draws are dropped until SEndFrame().
+#ifndef STDUI_GLES
+    PFNGLXWAITFORSBCOMLPROC waitForSbc; // GLX_OML_sync_control swap completion, NULL without it.
+#endif
+    double frameStart;       // When SBeginFrame() sampled input, frameClock() seconds.
+    double renderTime;       // Running average from frameStart to the swap being submitted.
+    double lastShown;        // When the last swap completed, close to a vblank when vsync is on.
+    SLatencyTracker latency;
+    SInputLog inputLog;      // See SRecordInput() and SReplayInput().
+#ifdef STDUI_USE_XCB
+    xcb_connection_t *connection; // The XCB side of display.
+    xcb_intern_atom_cookie_t protocolsCookie, deleteCookie, stateCookie, hiddenCookie;
+    xcb_get_property_cookie_t stateRequest; // In flight while stateChanged, see pollMinimizedState().
+#endif
+    // Software windows only, see SWindowCreateSoftware().
+    Visual *visual;
+    int depth;
+    GC gc;
+    SSoftwareBuffer softwareBuffers[2];
+    int softwareBack;        // The buffer SBeginSoftwareFrame() hands out next.
+    int shmCompletion;       // Event type of MIT-SHM completions, 0 when not presenting from shared memory.
+} SApplication;
+
+// Every window of the process shares one X connection, events are routed to the window they are for.
+static Display *sharedDisplay = NULL;
+static int sharedDisplayUsers = 0;
+#ifdef STDUI_USE_XCB
+// An event SWaitEvents() took off the XCB queue to see if one was there, drained first.
+static xcb_generic_event_t *xcbPendingEvent = NULL;
+#endif
+static SApplication *stduiWindows[STDUI_MAX_WINDOWS];
+static int stduiWindowCount = 0;
+
+// Unmapped, minimized or fully covered. Compositing window managers always report windows as
+// unobscured, there only unmapping and minimizing count.
+static bool windowHidden(SApplication *app) {
+    return !app->mapped || app->obscured || app->minimized;
+}
+
+// The context calls GLX and EGL builds differ in, everything else goes through these.
+#ifdef STDUI_GLES
+// EGL on sharedDisplay, initialized by the first GLES window and terminated with the display.
+static EGLDisplay sharedEglDisplay = EGL_NO_DISPLAY;
+static EGLConfig sharedEglConfig;
+
+static bool hasContext(SApplication *app) {
+    return app->eglContext != EGL_NO_CONTEXT;
+}
+
+static bool contextIsCurrent(SApplication *app) {
+    return eglGetCurrentContext() == app->eglContext;
+}
+
+static bool makeContextCurrent(SApplication *app) {
+    return eglMakeCurrent(sharedEglDisplay, app->eglSurface, app->eglSurface, app->eglContext);
+}
+
+static void swapWindowBuffers(SApplication *app) {
+    eglSwapBuffers(sharedEglDisplay, app->eglSurface);
+}
+
+// Releases the context if current and destroys it with its surface, before the window goes.
+static void destroyContext(SApplication *app) {
+    if (app->eglContext != EGL_NO_CONTEXT) {
+        if (contextIsCurrent(app)) {
+            eglMakeCurrent(sharedEglDisplay, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        }
+        eglDestroyContext(sharedEglDisplay, app->eglContext);
+    }
+    if (app->eglSurface != EGL_NO_SURFACE) {
+        eglDestroySurface(sharedEglDisplay, app->eglSurface);
+    }
+    app->eglContext = EGL_NO_CONTEXT;
+    app->eglSurface = EGL_NO_SURFACE;
+}
+#else
+static bool hasContext(SApplication *app) {
+    return app->glx_context != NULL;
+}
+
+static bool contextIsCurrent(SApplication *app) {
+    return glXGetCurrentContext() == app->glx_context;
+}
 
-#define GL_VERSION_3_3
+static bool makeContextCurrent(SApplication *app) {
+    return glXMakeCurrent(app->display, app->window, app->glx_context);
+}
 
-#include <X11/Xlib.h>
-#include <X11/keysym.h>
-#include <GL/glx.h>
-#include <GL/glxext.h>
-#include <GL/gl.h>
+static void swapWindowBuffers(SApplication *app) {
+    glXSwapBuffers(app->display, app->window);
+}
 
-typedef struct {
-    Display *display;
-    int screen;
-    Window window;
-    XEvent event;
-    GLXContext glx_context;  
-    Colormap colormap;
-    float mouseX;
-    float mouseY;
-    int mouseDown;
-} SApplication;
+static void destroyContext(SApplication *app) {
+    if (app->glx_context == NULL) {
+        return;
+    }
+    if (contextIsCurrent(app)) {
+        glXMakeCurrent(app->display, None, NULL);
+    }
+    glXDestroyContext(app->display, app->glx_context);
+    app->glx_context = NULL;
+}
+#endif
 
 
 // Forward declarations from other files (widget.h and image.h)
 bool initText(const char* fontPath);
-bool SInitializeRenderer(); 
+bool SInitializeRenderer();
+void setOrthographicProjection(GLuint programID, int width, int height);
+void SGetContextObjects(SContextObjects* objects);
+void SUseContextObjects(const SContextObjects* objects);
+void SDeleteContextObjects(SContextObjects* objects);
+void SCleanupRenderer();
+void SCleanupTextRenderer();
+void releaseGlyphWake(SApplication *app);
 
 extern SRenderer renderer;
 
-#ifdef IMAGE_H
-extern ImageRenderer* imageRenderer;
-void renderImage(ImageRenderer* renderer);
-#endif
-
 
+// The size comes from ConfigureNotify events, asking the server would be a round trip per call.
 static inline int SGetCurrentWindowWidth(SApplication *app) {
     if (app == NULL || app->display == NULL || app->window == 0) {
         return -1;
     }
-    
-    XWindowAttributes attr;
-    if (XGetWindowAttributes(app->display, app->window, &attr)) {
-        return attr.width;
-    } else {
-        fprintf(stderr, "Error: Could not retrieve window attributes.\n");
-        return -1; 
-    }
+    return app->width;
 }
 
 static inline int SGetCurrentWindowHeight(SApplication *app) {
     if (app == NULL || app->display == NULL || app->window == 0) {
         return -1;
     }
-    
-    XWindowAttributes attr;
-    if (XGetWindowAttributes(app->display, app->window, &attr)) {
-        return attr.height;
-    } else {
-        fprintf(stderr, "Error: Could not retrieve window attributes.\n");
-        return -1; 
+    return app->height;
+}
+
+
+// Refresh rate of the monitor showing the window, 60 when no source knows it.
+static double queryRefreshRate(SApplication *app) {
+#ifdef STDUI_XRANDR
+    int windowX = 0, windowY = 0;
+    Window child;
+    XTranslateCoordinates(app->display, app->window, RootWindow(app->display, app->screen),
+                          app->width / 2, app->height / 2, &windowX, &windowY, &child);
+
+    double rate = 0.0;
+    XRRScreenResources *resources = XRRGetScreenResourcesCurrent(app->display, app->window);
+    for (int i = 0; resources && i < resources->ncrtc; i++) {
+        XRRCrtcInfo *crtc = XRRGetCrtcInfo(app->display, resources, resources->crtcs[i]);
+        if (!crtc) {
+            continue;
+        }
+        bool covers = windowX >= crtc->x && windowX < crtc->x + (int)crtc->width &&
+                      windowY >= crtc->y && windowY < crtc->y + (int)crtc->height;
+        for (int j = 0; crtc->mode != None && j < resources->nmode; j++) {
+            const XRRModeInfo *mode = &resources->modes[j];
+            if (mode->id != crtc->mode || mode->hTotal == 0 || mode->vTotal == 0) {
+                continue;
+            }
+            double vTotal = (double)mode->vTotal;
+            if (mode->modeFlags & RR_DoubleScan) vTotal *= 2.0;
+            if (mode->modeFlags & RR_Interlace) vTotal /= 2.0;
+            // The first active monitor is the answer unless one actually shows the window.
+            if (rate == 0.0 || covers) {
+                rate = (double)mode->dotClock / ((double)mode->hTotal * vTotal);
+            }
+        }
+        XRRFreeCrtcInfo(crtc);
+        if (covers && rate > 0.0) {
+            break;
+        }
+    }
+    if (resources) {
+        XRRFreeScreenResources(resources);
+    }
+    if (rate > 0.0) {
+        return rate;
+    }
+#endif
+
+#ifndef STDUI_GLES
+    // Software windows run where GLX may not work at all, they stop at XRandR.
+    if (app->glx_context == NULL) {
+        return 60.0;
+    }
+    const char* glxExtensions = glXQueryExtensionsString(app->display, app->screen);
+    PFNGLXGETMSCRATEOMLPROC glXGetMscRateOML =
+        (PFNGLXGETMSCRATEOMLPROC) glXGetProcAddress((const GLubyte*)"glXGetMscRateOML");
+    int32_t numerator, denominator;
+    if (glXGetMscRateOML && glxExtensions && strstr(glxExtensions, "GLX_OML_sync_control") &&
+        glXGetMscRateOML(app->display, app->window, &numerator, &denominator) && numerator > 0 && denominator > 0) {
+        return (double)numerator / (double)denominator;
     }
+#endif
+    return 60.0;
 }
 
+// Set how many refreshes a swap waits for: 0 is unsynced, 1 is vsync, -1 is adaptive vsync
+// (tears instead of waiting when a frame is late) and falls back to 1 where unsupported.
+bool SSetSwapInterval(SApplication *app, int interval) {
+    if (app == NULL || app->display == NULL || app->window == 0) {
+        return false;
+    }
+
+#ifdef STDUI_GLES
+    // EGL sets the interval of the current surface and has no adaptive vsync.
+    if (!contextIsCurrent(app) && !makeContextCurrent(app)) {
+        return false;
+    }
+    interval = interval < 0 ? 1 : interval;
+    if (eglSwapInterval(sharedEglDisplay, interval)) {
+        app->swapInterval = interval;
+        return true;
+    }
+    fprintf(stderr, "ERROR: eglSwapInterval() failed, the swap interval is up to the driver.\n");
+    return false;
+#else
+    const char* glxExtensions = glXQueryExtensionsString(app->display, app->screen);
+    if (interval < 0 && !strstr(glxExtensions, "GLX_EXT_swap_control_tear")) {
+        interval = 1;
+    }
+
+    if (strstr(glxExtensions, "GLX_EXT_swap_control")) {
+        PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT =
+            (PFNGLXSWAPINTERVALEXTPROC) glXGetProcAddress((const GLubyte*)"glXSwapIntervalEXT");
+        if (glXSwapIntervalEXT) {
+            glXSwapIntervalEXT(app->display, app->window, interval);
+            app->swapInterval = interval;
+            return true;
+        }
+    }
+
+    interval = interval < 0 ? 1 : interval;
+    if (strstr(glxExtensions, "GLX_MESA_swap_control")) {
+        PFNGLXSWAPINTERVALMESAPROC glXSwapIntervalMESA =
+            (PFNGLXSWAPINTERVALMESAPROC) glXGetProcAddress((const GLubyte*)"glXSwapIntervalMESA");
+        if (glXSwapIntervalMESA && glXSwapIntervalMESA((unsigned int)interval) == 0) {
+            app->swapInterval = interval;
+            return true;
+        }
+    }
+
+    // SGI only knows intervals of 1 and up.
+    if (interval > 0 && strstr(glxExtensions, "GLX_SGI_swap_control")) {
+        PFNGLXSWAPINTERVALSGIPROC glXSwapIntervalSGI =
+            (PFNGLXSWAPINTERVALSGIPROC) glXGetProcAddress((const GLubyte*)"glXSwapIntervalSGI");
+        if (glXSwapIntervalSGI && glXSwapIntervalSGI(interval) == 0) {
+            app->swapInterval = interval;
+            return true;
+        }
+    }
+
+    fprintf(stderr, "ERROR: No GLX swap control extension, the swap interval is up to the driver.\n");
+    return false;
+#endif
+}
 
 //Implementation of funcs.
 int SDisplayOpen(SApplication *app) {
     if (app == NULL) {
         return 0;
     }
-    app->display = XOpenDisplay(NULL);
-    if (app->display == NULL) {
-        fprintf(stderr, "ERROR: Unable to open X11 display.\n");
-        return 0;
+    // Applications keep this on the stack, state that no window sets up has to start out zero.
+    memset(app, 0, sizeof(*app));
+    app->wakeFd = -1;
+    if (sharedDisplay == NULL) {
+        sharedDisplay = XOpenDisplay(NULL);
+        if (sharedDisplay == NULL) {
+            fprintf(stderr, "ERROR: Unable to open X11 display.\n");
+            return 0;
+        }
+        #ifdef STDUI_USE_XCB
+        // From here on events are read with xcb_poll_for_event(), XNextEvent() would never see them.
+        XSetEventQueueOwner(sharedDisplay, XCBOwnsEventQueue);
+        #endif
+        #ifdef STDUI_VERBAL_DEBUG
+        printf("STATUS: Opened Display with code 0. \n");
+        #endif
     }
-    #ifdef STDUI_VERBAL_DEBUG
-    printf("STATUS: Opened Display with code 0. \n");
-    #endif
+    app->display = sharedDisplay;
+    sharedDisplayUsers++;
     
     app->screen = DefaultScreen(app->display);
+    #ifdef STDUI_USE_XCB
+    app->connection = XGetXCBConnection(app->display);
+    #endif
     return 1;
 }
 
+// Create the X window, hook up the events and reset the per-window state. Shared by GL and
+// software windows, the window is mapped by mapNativeWindow() once it is ready to draw.
+static bool createNativeWindow(SApplication *app, const char *title, int x, int y, int width, int height,
+                               XVisualInfo *vi) {
+#ifdef STDUI_USE_XCB
+    // The atoms are only needed by mapNativeWindow(), their replies arrive meanwhile.
+    app->protocolsCookie = xcb_intern_atom(app->connection, 0, 12, "WM_PROTOCOLS");
+    app->deleteCookie = xcb_intern_atom(app->connection, 0, 16, "WM_DELETE_WINDOW");
+    app->stateCookie = xcb_intern_atom(app->connection, 0, 13, "_NET_WM_STATE");
+    app->hiddenCookie = xcb_intern_atom(app->connection, 0, 20, "_NET_WM_STATE_HIDDEN");
+
+    xcb_window_t root = (xcb_window_t)RootWindow(app->display, app->screen);
+    app->colormap = xcb_generate_id(app->connection);
+    xcb_create_colormap(app->connection, XCB_COLORMAP_ALLOC_NONE, app->colormap, root, (xcb_visualid_t)vi->visualid);
+
+    // Values go in the order of their XCB_CW_* bits.
+    uint32_t windowValues[] = {
+        0,
+        XCB_EVENT_MASK_EXPOSURE | XCB_EVENT_MASK_KEY_PRESS | XCB_EVENT_MASK_KEY_RELEASE |
+        XCB_EVENT_MASK_BUTTON_PRESS | XCB_EVENT_MASK_BUTTON_RELEASE | XCB_EVENT_MASK_POINTER_MOTION |
+        XCB_EVENT_MASK_STRUCTURE_NOTIFY | XCB_EVENT_MASK_FOCUS_CHANGE |
+        XCB_EVENT_MASK_VISIBILITY_CHANGE | XCB_EVENT_MASK_PROPERTY_CHANGE,
+        (uint32_t)app->colormap
+    };
+    app->window = xcb_generate_id(app->connection);
+    xcb_create_window(app->connection, (uint8_t)vi->depth, (xcb_window_t)app->window, root,
+                      (int16_t)x, (int16_t)y, (uint16_t)width, (uint16_t)height, 0,
+                      XCB_WINDOW_CLASS_INPUT_OUTPUT, (xcb_visualid_t)vi->visualid,
+                      XCB_CW_BORDER_PIXEL | XCB_CW_EVENT_MASK | XCB_CW_COLORMAP, windowValues);
+    xcb_change_property(app->connection, XCB_PROP_MODE_REPLACE, (xcb_window_t)app->window,
+                        XCB_ATOM_WM_NAME, XCB_ATOM_STRING, 8, (uint32_t)strlen(title), title);
+    // Failures come back as error events, SEventProcess() reports them.
+#else
+    // Create colormap.
+    app->colormap = XCreateColormap(app->display, RootWindow(app->display, app->screen), 
+                                    vi->visual, AllocNone);
+    
+    // Window attribs.
+    XSetWindowAttributes swa;
+    swa.colormap = app->colormap;
+    swa.event_mask = ExposureMask | KeyPressMask | KeyReleaseMask | ButtonPressMask | ButtonReleaseMask |
+                     PointerMotionMask | StructureNotifyMask | FocusChangeMask | // Keys, mouse, resizes and focus.
+                     VisibilityChangeMask | PropertyChangeMask; // Whether the window can be seen.
+    
+    // Create window.
+    app->window = XCreateWindow(app->display, RootWindow(app->display, app->screen), 
+                                x, y, width, height, 0, vi->depth, InputOutput, 
+                                vi->visual, CWColormap | CWEventMask, &swa);
+    
+    if (!app->window) {
+        fprintf(stderr, "ERROR: Failed to create window\n");
+        return false;
+    }
+    
+    // Set window title.
+    XStoreName(app->display, app->window, title);
+
+    // Ask the window manager for a ClientMessage instead of killing the connection on close.
+    app->wmDeleteWindow = XInternAtom(app->display, "WM_DELETE_WINDOW", False);
+    XSetWMProtocols(app->display, app->window, &app->wmDeleteWindow, 1);
+    app->netWmState = XInternAtom(app->display, "_NET_WM_STATE", False);
+    app->netWmStateHidden = XInternAtom(app->display, "_NET_WM_STATE_HIDDEN", False);
+#endif
+
+    memset(&app->events, 0, sizeof(app->events));
+    memset(&app->inputLog, 0, sizeof(app->inputLog));
+    memset(&app->input, 0, sizeof(app->input));
+    app->width = width;
+    app->height = height;
+    app->viewportWidth = app->viewportHeight = 0; // Set up by the first SBeginFrame().
+    app->redraw = 1;
+    app->xiOpcode = 0;
+    // Hidden until the MapNotify, frames before it would not be shown anyway.
+    app->mapped = app->obscured = app->minimized = false;
+    app->stateChanged = false;
+    app->frameHidden = false;
+    // Set up by SWindowCreateSoftware(), GL windows keep them empty.
+    app->visual = NULL;
+    app->depth = 0;
+    app->gc = NULL;
+    memset(app->softwareBuffers, 0, sizeof(app->softwareBuffers));
+    app->softwareBack = 0;
+    app->shmCompletion = 0;
+
+#ifdef STDUI_XINPUT2
+    // With XInput2 selected the server stops sending the core pointer events to this window.
+    int xiEvent, xiError;
+    if (XQueryExtension(app->display, "XInputExtension", &app->xiOpcode, &xiEvent, &xiError)) {
+        int major = 2, minor = 0;
+        if (XIQueryVersion(app->display, &major, &minor) == Success) {
+            unsigned char mask[XIMaskLen(XI_LASTEVENT)];
+            memset(mask, 0, sizeof(mask));
+            XISetMask(mask, XI_ButtonPress);
+            XISetMask(mask, XI_ButtonRelease);
+            XISetMask(mask, XI_Motion);
+            XIEventMask eventMask = { XIAllMasterDevices, sizeof(mask), mask };
+            XISelectEvents(app->display, app->window, &eventMask, 1);
+        } else {
+            app->xiOpcode = 0;
+        }
+    } else {
+        app->xiOpcode = 0;
+    }
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: XInput2 pointer events %s.\n", app->xiOpcode ? "enabled" : "not available");
+    #endif
+#endif
+
+    // Other threads wake the event loop through this, see SPostEmptyEvent().
+    app->wakeFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (app->wakeFd < 0) {
+        fprintf(stderr, "ERROR: Failed to create wake up eventfd, SPostEmptyEvent() will not wake the loop.\n");
+    }
+
+    return true;
+}
+
+static void mapNativeWindow(SApplication *app) {
+#ifdef STDUI_USE_XCB
+    // Creating a GL context takes round trips anyway, the atom replies are usually here by now.
+    xcb_intern_atom_reply_t *protocols = xcb_intern_atom_reply(app->connection, app->protocolsCookie, NULL);
+    xcb_intern_atom_reply_t *deleteWindow = xcb_intern_atom_reply(app->connection, app->deleteCookie, NULL);
+    app->wmDeleteWindow = deleteWindow ? deleteWindow->atom : None;
+    if (protocols && deleteWindow) {
+        xcb_change_property(app->connection, XCB_PROP_MODE_REPLACE, (xcb_window_t)app->window,
+                            protocols->atom, XCB_ATOM_ATOM, 32, 1, &deleteWindow->atom);
+    }
+    free(protocols);
+    free(deleteWindow);
+
+    xcb_intern_atom_reply_t *state = xcb_intern_atom_reply(app->connection, app->stateCookie, NULL);
+    xcb_intern_atom_reply_t *hidden = xcb_intern_atom_reply(app->connection, app->hiddenCookie, NULL);
+    app->netWmState = state ? state->atom : None;
+    app->netWmStateHidden = hidden ? hidden->atom : None;
+    free(state);
+    free(hidden);
+
+    xcb_map_window(app->connection, (xcb_window_t)app->window);
+    xcb_flush(app->connection);
+#else
+    // Map window.
+    XMapWindow(app->display, app->window);
+#endif
+}
+
+#ifdef STDUI_GLES
+// The first GL context joins no group, later ones share with it.
+static EGLContext shareGroupContext(void) {
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (hasContext(stduiWindows[i])) {
+            return stduiWindows[i]->eglContext;
+        }
+    }
+    return EGL_NO_CONTEXT;
+}
+
+// Initialize EGL on the first call and return the X visual of its config, XFree() it.
+static XVisualInfo* chooseEglVisual(SApplication *app) {
+    if (sharedEglDisplay == EGL_NO_DISPLAY) {
+        static const EGLint configAttribs[] = {
+            EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+            EGL_RENDERABLE_TYPE, STDUI_EGL_RENDERABLE_TYPE,
+            EGL_RED_SIZE, 8,
+            EGL_GREEN_SIZE, 8,
+            EGL_BLUE_SIZE, 8,
+            EGL_ALPHA_SIZE, 8,
+            EGL_DEPTH_SIZE, 24,
+            EGL_STENCIL_SIZE, 8,
+            EGL_NONE
+        };
+        EGLint configCount = 0;
+        EGLDisplay display = eglGetDisplay((EGLNativeDisplayType)app->display);
+        if (display == EGL_NO_DISPLAY || !eglInitialize(display, NULL, NULL)) {
+            fprintf(stderr, "ERROR: Failed to initialize EGL on the X display.\n");
+            return NULL;
+        }
+        if (!eglChooseConfig(display, configAttribs, &sharedEglConfig, 1, &configCount) || configCount == 0) {
+            fprintf(stderr, "ERROR: No EGL config for " STDUI_EGL_API_NAME " on this X display.\n");
+            eglTerminate(display);
+            return NULL;
+        }
+        sharedEglDisplay = display;
+    }
+
+    EGLint visualId = 0;
+    eglGetConfigAttrib(sharedEglDisplay, sharedEglConfig, EGL_NATIVE_VISUAL_ID, &visualId);
+    XVisualInfo visualTemplate;
+    visualTemplate.visualid = (VisualID)visualId;
+    int count = 0;
+    XVisualInfo *vi = XGetVisualInfo(app->display, VisualIDMask, &visualTemplate, &count);
+    if (vi == NULL) {
+        fprintf(stderr, "ERROR: No appropriate visual found\n");
+    }
+    return vi;
+}
+
+static bool createEglContext(SApplication *app) {
+    static const EGLint contextAttribs[] = { STDUI_EGL_CONTEXT_ATTRIBS };
+    // The bound API is per thread, set it for every window.
+    eglBindAPI(STDUI_EGL_API);
+    app->eglSurface = eglCreateWindowSurface(sharedEglDisplay, sharedEglConfig, (EGLNativeWindowType)app->window, NULL);
+    app->eglContext = eglCreateContext(sharedEglDisplay, sharedEglConfig, shareGroupContext(), contextAttribs);
+    if (app->eglSurface == EGL_NO_SURFACE || app->eglContext == EGL_NO_CONTEXT) {
+        fprintf(stderr, "ERROR: Failed to create OpenGL context.\n");
+        destroyContext(app);
+        return false;
+    }
+
+    if (!makeContextCurrent(app)) {
+        fprintf(stderr, "ERROR: Failed to make context current.\n");
+        destroyContext(app);
+        return false;
+    }
+    return true;
+}
+#else
+// The first GL context joins no group, later ones share with it.
+static GLXContext shareGroupContext(void) {
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (hasContext(stduiWindows[i])) {
+            return stduiWindows[i]->glx_context;
+        }
+    }
+    return NULL;
+}
+#endif
+
 int SWindowCreate(SApplication *app, const char *title, int x, int y, int width, int height) {
     if (app == NULL) {
         return 0;
     }
-    
+
+    if (stduiWindowCount >= STDUI_MAX_WINDOWS) {
+        fprintf(stderr, "ERROR: Too many windows (max %d)\n", STDUI_MAX_WINDOWS);
+        return 0;
+    }
+
+#ifdef STDUI_GLES
+    XVisualInfo *vi = chooseEglVisual(app);
+    if (!vi) {
+        return 0;
+    }
+#else
     // Check that the required GLX extension is available
     const char* glxExtensions = glXQueryExtensionsString(app->display, app->screen);
     if (!strstr(glxExtensions, "GLX_ARB_create_context")) {
@@ -169,30 +2464,25 @@ int SWindowCreate(SApplication *app, const char *title, int x, int y, int width,
         fprintf(stderr, "ERROR: No appropriate visual found\n");
         return 0;
     }
-    
-    // Create colormap.
-    app->colormap = XCreateColormap(app->display, RootWindow(app->display, app->screen), 
-                                    vi->visual, AllocNone);
-    
-    // Window attribs.
-    XSetWindowAttributes swa;
-    swa.colormap = app->colormap;
-    swa.event_mask = ExposureMask | KeyPressMask | ButtonPressMask | ButtonReleaseMask | PointerMotionMask; //KeyPress, Mouse and Exposure.
-    
-    // Create window.
-    app->window = XCreateWindow(app->display, RootWindow(app->display, app->screen), 
-                                x, y, width, height, 0, vi->depth, InputOutput, 
-                                vi->visual, CWColormap | CWEventMask, &swa);
-    
-    if (!app->window) {
-        fprintf(stderr, "ERROR: Failed to create window\n");
+#endif
+
+    if (!createNativeWindow(app, title, x, y, width, height, vi)) {
         XFree(vi);
         return 0;
     }
-    
-    // Set window title.
-    XStoreName(app->display, app->window, title);
-    
+
+    memset(&app->contextObjects, 0, sizeof(app->contextObjects));
+
+#ifdef STDUI_GLES
+    if (!createEglContext(app)) {
+        XFree(vi);
+        XDestroyWindow(app->display, app->window);
+        return 0;
+    }
+#else
+    // Join the share group of the windows that already exist.
+    GLXContext shareContext = shareGroupContext();
+
     // Get the function to create OpenGL 3.3 context.
     PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB = 
         (PFNGLXCREATECONTEXTATTRIBSARBPROC) glXGetProcAddress((const GLubyte*)"glXCreateContextAttribsARB");
@@ -200,9 +2490,9 @@ int SWindowCreate(SApplication *app, const char *title, int x, int y, int width,
     if (!glXCreateContextAttribsARB) {
         fprintf(stderr, "ERROR: glXCreateContextAttribsARB() not found\n");
         // Fall back to older method
-        app->glx_context = glXCreateNewContext(app->display, bestFbc, GLX_RGBA_TYPE, NULL, True);
+        app->glx_context = glXCreateNewContext(app->display, bestFbc, GLX_RGBA_TYPE, shareContext, True);
     } else {
-        app->glx_context = glXCreateContextAttribsARB(app->display, bestFbc, NULL, True, context_attribs);
+        app->glx_context = glXCreateContextAttribsARB(app->display, bestFbc, shareContext, True, context_attribs);
     }
     
     // Verify context.
@@ -212,96 +2502,748 @@ int SWindowCreate(SApplication *app, const char *title, int x, int y, int width,
         XDestroyWindow(app->display, app->window);
         return 0;
     }
-    
-    // Make context current.
-    if (!glXMakeCurrent(app->display, app->window, app->glx_context)) {
-        fprintf(stderr, "ERROR: Failed to make context current.\n");
-        glXDestroyContext(app->display, app->glx_context);
-        app->glx_context = NULL;
-        XFree(vi);
-        XDestroyWindow(app->display, app->window);
-        return 0;
+    
+    // Make context current.
+    if (!makeContextCurrent(app)) {
+        fprintf(stderr, "ERROR: Failed to make context current.\n");
+        destroyContext(app);
+        XFree(vi);
+        XDestroyWindow(app->display, app->window);
+        return 0;
+    }
+#endif
+
+    mapNativeWindow(app);
+    
+    const char* version = (const char*)glGetString(GL_VERSION);
+    const char* shaderVersion = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
+
+    if (!version || !shaderVersion) {
+        fprintf(stderr, "ERROR: Failed to get OpenGL version information.\n");
+        destroyContext(app);
+        XFree(vi);
+        XDestroyWindow(app->display, app->window);
+        return 0;
+    }
+
+    // Sync to the monitor unless the application asks otherwise.
+    SSetSwapInterval(app, 1);
+    initFramePacer(&app->pacer, queryRefreshRate(app));
+
+    // Enable blending for text.
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+
+    // Initialize renderer, only the first window creates the shared objects.
+    if (!SInitializeRenderer()) {
+        fprintf(stderr, "ERROR: Failed to initialize rendering.\n");
+        destroyContext(app);
+        XFree(vi);
+        XDestroyWindow(app->display, app->window);
+        return 0;
+    }
+    
+    // Initialize text rendering.
+    if (!initText(NULL)) {
+        fprintf(stderr, "ERROR: Failed to initialize text rendering.\n");
+        destroyContext(app);
+        XFree(vi);
+        XDestroyWindow(app->display, app->window);
+        return 0;
+    }
+
+    SGetContextObjects(&app->contextObjects);
+    stduiWindows[stduiWindowCount++] = app;
+
+    #ifdef STDUI_VERBAL_DEBUG
+    printf("STATUS: Window created with code 0: \n OpenGL version: %s\n GLSL version: %s \n", version, shaderVersion);
+    #endif
+
+    XFree(vi);
+    XFlush(app->display);
+    return 1;
+}
+
+#ifdef STDUI_XSHM
+static bool shmAttachFailed = false;
+
+static int catchShmError(Display *display, XErrorEvent *error) {
+    (void)display;
+    (void)error;
+    shmAttachFailed = true;
+    return 0;
+}
+
+static Bool isShmCompletion(Display *display, XEvent *event, XPointer arg) {
+    (void)display;
+    SApplication *app = (SApplication*)arg;
+    return event->type == app->shmCompletion && event->xany.window == app->window;
+}
+
+static void releaseSoftwareBuffer(SApplication *app, ShmSeg segment) {
+    for (int i = 0; i < 2; i++) {
+        if (app->softwareBuffers[i].shared && app->softwareBuffers[i].shm.shmseg == segment) {
+            app->softwareBuffers[i].busy = false;
+        }
+    }
+}
+#endif
+
+static void freeSoftwareBuffer(SApplication *app, SSoftwareBuffer *buffer) {
+    (void)app; // Only MIT-SHM buffers have a segment to detach.
+    if (buffer->image == NULL) {
+        return;
+    }
+#ifdef STDUI_XSHM
+    if (buffer->shared) {
+        XShmDetach(app->display, &buffer->shm);
+        buffer->image->data = NULL; // Not ours to free, the segment goes away once both sides detach.
+        XDestroyImage(buffer->image);
+        shmdt(buffer->shm.shmaddr);
+        memset(buffer, 0, sizeof(*buffer));
+        return;
+    }
+#endif
+    XDestroyImage(buffer->image); // Frees the pixels too.
+    memset(buffer, 0, sizeof(*buffer));
+}
+
+static bool allocSoftwareBuffer(SApplication *app, SSoftwareBuffer *buffer, int width, int height) {
+    memset(buffer, 0, sizeof(*buffer));
+
+#ifdef STDUI_XSHM
+    if (app->shmCompletion != 0) {
+        buffer->image = XShmCreateImage(app->display, app->visual, (unsigned int)app->depth, ZPixmap, NULL,
+                                        &buffer->shm, (unsigned int)width, (unsigned int)height);
+        if (buffer->image) {
+            buffer->shm.shmid = shmget(IPC_PRIVATE, (size_t)buffer->image->bytes_per_line * (size_t)height, IPC_CREAT | 0600);
+            buffer->shm.shmaddr = buffer->shm.shmid >= 0 ? (char*)shmat(buffer->shm.shmid, NULL, 0) : (char*)-1;
+            if (buffer->shm.shmaddr != (char*)-1) {
+                buffer->image->data = buffer->shm.shmaddr;
+                buffer->shm.readOnly = True;
+
+                // Attach errors come back asynchronously, this is the one round trip per buffer.
+                shmAttachFailed = false;
+                XErrorHandler previous = XSetErrorHandler(catchShmError);
+                XShmAttach(app->display, &buffer->shm);
+                XSync(app->display, False);
+                XSetErrorHandler(previous);
+                shmctl(buffer->shm.shmid, IPC_RMID, NULL); // Freed once both sides detach.
+
+                if (!shmAttachFailed) {
+                    buffer->shared = true;
+                    return true;
+                }
+                shmdt(buffer->shm.shmaddr);
+            } else if (buffer->shm.shmid >= 0) {
+                shmctl(buffer->shm.shmid, IPC_RMID, NULL);
+            }
+            buffer->image->data = NULL;
+            XDestroyImage(buffer->image);
+            buffer->image = NULL;
+        }
+
+        // A remote display cannot see our memory, copy through the socket from now on.
+        fprintf(stderr, "ERROR: MIT-SHM not usable, presenting software frames through the X socket.\n");
+        app->shmCompletion = 0;
+    }
+#endif
+
+    char *pixels = (char*)malloc((size_t)width * (size_t)height * 4);
+    if (pixels == NULL) {
+        fprintf(stderr, "ERROR: Failed to allocate a %dx%d software framebuffer.\n", width, height);
+        return false;
+    }
+    buffer->image = XCreateImage(app->display, app->visual, (unsigned int)app->depth, ZPixmap, 0, pixels,
+                                 (unsigned int)width, (unsigned int)height, 32, 0);
+    if (buffer->image == NULL) {
+        free(pixels);
+        fprintf(stderr, "ERROR: Failed to create a software framebuffer image.\n");
+        return false;
     }
-    
-    // Map window.
-    XMapWindow(app->display, app->window);
-    
-    const char* version = (const char*)glGetString(GL_VERSION);
-    const char* shaderVersion = (const char*)glGetString(GL_SHADING_LANGUAGE_VERSION);
+    return true;
+}
 
-    if (!version || !shaderVersion) {
-        fprintf(stderr, "ERROR: Failed to get OpenGL version information.\n");
-        glXDestroyContext(app->display, app->glx_context);
-        app->glx_context = NULL;
-        XFree(vi);
-        XDestroyWindow(app->display, app->window);
+// Create a window without GL for frames rasterized on the CPU, for when no usable GL exists.
+// Draw with SBeginSoftwareFrame() and SEndSoftwareFrame() instead of SBeginFrame()/SEndFrame().
+// With STDUI_XSHM the framebuffers live in MIT-SHM shared memory and are never copied through
+// the X socket.
+int SWindowCreateSoftware(SApplication *app, const char *title, int x, int y, int width, int height) {
+    if (app == NULL || app->display == NULL) {
         return 0;
     }
 
-    // Enable blending for text.
-    glEnable(GL_BLEND);
-    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    if (stduiWindowCount >= STDUI_MAX_WINDOWS) {
+        fprintf(stderr, "ERROR: Too many windows (max %d)\n", STDUI_MAX_WINDOWS);
+        return 0;
+    }
 
-    // Initialize renderer
-    if (!SInitializeRenderer()) {
-        fprintf(stderr, "ERROR: Failed to initialize rendering.\n");
-        glXDestroyContext(app->display, app->glx_context);
-        app->glx_context = NULL;
-        XFree(vi);
-        XDestroyWindow(app->display, app->window);
+    // SFramebuffer pixels are written as 0x00RRGGBB words.
+    XVisualInfo vi;
+    if (!XMatchVisualInfo(app->display, app->screen, 24, TrueColor, &vi) ||
+        vi.red_mask != 0xff0000 || vi.green_mask != 0x00ff00 || vi.blue_mask != 0x0000ff) {
+        fprintf(stderr, "ERROR: No 24 bit TrueColor visual for a software window.\n");
         return 0;
     }
-    
-    // Initialize text rendering.
-    if (!initText("stdui/internal/courier_new.ttf")) {
-        fprintf(stderr, "ERROR: Failed to initialize text rendering.\n");
-        glXDestroyContext(app->display, app->glx_context);
-        app->glx_context = NULL;
-        XFree(vi);
-        XDestroyWindow(app->display, app->window);
+
+    if (!createNativeWindow(app, title, x, y, width, height, &vi)) {
         return 0;
     }
 
-    setOrthographicProjection(renderer.basicProgram, SGetCurrentWindowWidth(app), SGetCurrentWindowHeight(app));
+#ifdef STDUI_GLES
+    app->eglSurface = EGL_NO_SURFACE;
+    app->eglContext = EGL_NO_CONTEXT;
+#else
+    app->glx_context = NULL;
+#endif
+    memset(&app->contextObjects, 0, sizeof(app->contextObjects));
+    app->visual = vi.visual;
+    app->depth = vi.depth;
+    app->gc = XCreateGC(app->display, app->window, 0, NULL);
+#ifdef STDUI_XSHM
+    if (XShmQueryExtension(app->display)) {
+        app->shmCompletion = XShmGetEventBase(app->display) + ShmCompletion;
+    }
+#endif
+
+    mapNativeWindow(app);
+    app->swapInterval = 0;
+    initFramePacer(&app->pacer, queryRefreshRate(app));
+    stduiWindows[stduiWindowCount++] = app;
 
     #ifdef STDUI_VERBAL_DEBUG
-    printf("STATUS: Window created with code 0: \n OpenGL version: %s\n GLSL version: %s \n", version, shaderVersion);
+    printf("STATUS: Software window created, %s.\n", app->shmCompletion ? "MIT-SHM present" : "socket present");
     #endif
-    
-    XFree(vi);
+
     XFlush(app->display);
     return 1;
 }
 
+// Hand out the framebuffer for the next frame, sized to the window. Two buffers alternate, so
+// this frame is drawn while the server still reads the last one; only when it has not let go
+// of the older one yet does this wait. pixels is NULL on failure.
+SFramebuffer SBeginSoftwareFrame(SApplication *app) {
+    SFramebuffer framebuffer;
+    memset(&framebuffer, 0, sizeof(framebuffer));
+    if (app == NULL || app->display == NULL || app->gc == NULL) {
+        return framebuffer;
+    }
+
+    app->redraw = 0;
+    app->frameHidden = windowHidden(app);
+    SSoftwareBuffer *buffer = &app->softwareBuffers[app->softwareBack];
+#ifdef STDUI_XSHM
+    while (buffer->busy) {
+        XEvent event;
+        XIfEvent(app->display, &event, isShmCompletion, (XPointer)app);
+        releaseSoftwareBuffer(app, ((XShmCompletionEvent*)&event)->shmseg);
+    }
+#endif
+
+    if (buffer->image && (buffer->image->width != app->width || buffer->image->height != app->height)) {
+        freeSoftwareBuffer(app, buffer);
+    }
+    if (buffer->image == NULL && (app->width <= 0 || app->height <= 0 ||
+                                  !allocSoftwareBuffer(app, buffer, app->width, app->height))) {
+        return framebuffer;
+    }
+
+    framebuffer.pixels = (unsigned int*)buffer->image->data;
+    framebuffer.width = buffer->image->width;
+    framebuffer.height = buffer->image->height;
+    framebuffer.stride = buffer->image->bytes_per_line / 4;
+    return framebuffer;
+}
+
+// Present the framebuffer from SBeginSoftwareFrame() and flip to the other one.
+void SEndSoftwareFrame(SApplication *app) {
+    if (app == NULL || app->display == NULL || app->gc == NULL) {
+        return;
+    }
+
+    SSoftwareBuffer *buffer = &app->softwareBuffers[app->softwareBack];
+    if (buffer->image == NULL) {
+        return;
+    }
+    if (app->frameHidden) {
+        // Nobody would see it, keep the buffer for the next frame.
+        app->frameHidden = false;
+        paceHiddenFrame(&app->pacer);
+        return;
+    }
+
+#ifdef STDUI_XSHM
+    if (buffer->shared) {
+        // The server reads the segment directly and says when it is done with a ShmCompletion.
+        XShmPutImage(app->display, app->window, app->gc, buffer->image, 0, 0, 0, 0,
+                     (unsigned int)buffer->image->width, (unsigned int)buffer->image->height, True);
+        buffer->busy = true;
+    } else
+#endif
+    {
+        XPutImage(app->display, app->window, app->gc, buffer->image, 0, 0, 0, 0,
+                  (unsigned int)buffer->image->width, (unsigned int)buffer->image->height);
+    }
+    XFlush(app->display);
+
+    app->softwareBack ^= 1;
+    paceFrame(&app->pacer);
+}
+
+// Copy the pointer state tracked from events into mouseX, mouseY and mouseDown. A left click
+// that started and ended since the last drain still reads as down for that frame.
 void SGetMouseState(SApplication *app) {
     if (app == NULL) {
         return;
     }
-    
-    Window root_return, child_return;
-    int root_x_return, root_y_return;
-    int win_x_return, win_y_return;
-    unsigned int mask_return;
-    
-    Bool result = XQueryPointer(app->display, app->window, 
-                 &root_return, &child_return,
-                 &root_x_return, &root_y_return,
-                 &win_x_return, &win_y_return,
-                 &mask_return);
-                 
-    if (result == False) {
-        // Pointer is not on the same screen as the window
+
+    app->mouseX = app->input.mouseX;
+    app->mouseY = app->input.mouseY;
+    app->mouseDown = ((app->input.buttons | app->input.pressed) & 1) ? 1 : 0;
+}
+
+static SApplication* findWindow(Window window) {
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i]->window == window) {
+            return stduiWindows[i];
+        }
+    }
+    return NULL;
+}
+
+static unsigned int translateModifiers(unsigned int state) {
+    unsigned int modifiers = 0;
+    if (state & ShiftMask)   modifiers |= SMOD_SHIFT;
+    if (state & ControlMask) modifiers |= SMOD_CONTROL;
+    if (state & Mod1Mask)    modifiers |= SMOD_ALT;
+    if (state & Mod4Mask)    modifiers |= SMOD_SUPER;
+    if (state & LockMask)    modifiers |= SMOD_CAPS_LOCK;
+    if (state & Mod2Mask)    modifiers |= SMOD_NUM_LOCK;
+    return modifiers;
+}
+
+// Fill a button or wheel event from an X button number, returns false for wheel releases.
+static bool translateButton(SEvent *event, bool press, unsigned int button) {
+    // Buttons 4 to 7 are the wheel, only their press matters.
+    if (button >= 4 && button <= 7) {
+        if (!press) {
+            return false;
+        }
+        event->type = SEVENT_SCROLL;
+        event->scrollY = button == 4 ? 1.0f : button == 5 ? -1.0f : 0.0f;
+        event->scrollX = button == 7 ? 1.0f : button == 6 ? -1.0f : 0.0f;
+    } else {
+        event->type = press ? SEVENT_BUTTON_PRESS : SEVENT_BUTTON_RELEASE;
+        // X buttons 8 and up follow the wheel, shift them down so back and forward are 4 and 5.
+        event->button = button > 7 ? (int)button - 4 : (int)button;
+        if (event->button < 1 || event->button > 32) {
+            return false; // X allows up to 255, the input masks hold 32.
+        }
+    }
+    return true;
+}
+
+#ifdef STDUI_XINPUT2
+static bool translateXIEvent(SApplication *app, XGenericEventCookie *cookie, SEvent *event, Window *window) {
+    if (!XGetEventData(app->display, cookie)) {
+        return false;
+    }
+
+    XIDeviceEvent *device = (XIDeviceEvent*)cookie->data;
+    bool keep = true;
+    *window = device->event;
+    event->x = (float)device->event_x;
+    event->y = (float)device->event_y;
+    event->time = (unsigned long)device->time;
+    event->modifiers = translateModifiers((unsigned int)device->mods.effective);
+
+    switch (cookie->evtype) {
+        case XI_ButtonPress:
+        case XI_ButtonRelease:
+            keep = translateButton(event, cookie->evtype == XI_ButtonPress, (unsigned int)device->detail);
+            break;
+        case XI_Motion:
+            event->type = SEVENT_MOTION;
+            break;
+        default:
+            keep = false;
+            break;
+    }
+
+    XFreeEventData(app->display, cookie);
+    return keep;
+}
+#endif
+
+// _NET_WM_STATE changed, window managers set _NET_WM_STATE_HIDDEN in it on minimized windows.
+// Nothing waits for the property here, pollMinimizedState() updates minimized after the drain.
+#ifdef STDUI_USE_XCB
+// The request goes out now and its reply is picked up once it arrived. A newer change replaces
+// a request still in flight.
+static void requestMinimizedState(SApplication *app) {
+    if (app->stateChanged) {
+        xcb_discard_reply(app->connection, app->stateRequest.sequence);
+    }
+    app->stateRequest = xcb_get_property(app->connection, 0, (xcb_window_t)app->window,
+                                         (xcb_atom_t)app->netWmState, XCB_ATOM_ATOM, 0, 64);
+    app->stateChanged = true;
+}
+
+static void pollMinimizedState(SApplication *app) {
+    if (!app->stateChanged) {
         return;
     }
-    
-    // Update mouse position.
-    app->mouseX = (float)win_x_return;
-    app->mouseY = (float)win_y_return;
-    
-    // Update mouse button state.
-    app->mouseDown = (mask_return & Button1Mask) ? 1 : 0;
+    void *reply = NULL;
+    xcb_generic_error_t *error = NULL;
+    if (!xcb_poll_for_reply(app->connection, app->stateRequest.sequence, &reply, &error)) {
+        return; // Not there yet, the next drain looks again.
+    }
+    app->stateChanged = false;
+
+    bool minimized = false;
+    if (reply) {
+        const xcb_atom_t *states = (const xcb_atom_t*)xcb_get_property_value((xcb_get_property_reply_t*)reply);
+        int count = xcb_get_property_value_length((xcb_get_property_reply_t*)reply) / (int)sizeof(xcb_atom_t);
+        for (int i = 0; i < count; i++) {
+            minimized = minimized || states[i] == (xcb_atom_t)app->netWmStateHidden;
+        }
+        free(reply);
+    }
+    free(error);
+    app->minimized = minimized && app->netWmStateHidden != None;
+    app->redraw = 1;
+}
+#else
+// Xlib has no asynchronous property read, one round trip after the drain covers every change
+// that came in with it.
+static void requestMinimizedState(SApplication *app) {
+    app->stateChanged = true;
+}
+
+static void pollMinimizedState(SApplication *app) {
+    if (!app->stateChanged) {
+        return;
+    }
+    app->stateChanged = false;
+
+    bool minimized = false;
+    Atom type;
+    int format;
+    unsigned long count, remaining;
+    unsigned char *data = NULL;
+    if (XGetWindowProperty(app->display, app->window, app->netWmState, 0, 64, False, XA_ATOM,
+                           &type, &format, &count, &remaining, &data) == Success && data) {
+        const Atom *states = (const Atom*)data;
+        for (unsigned long i = 0; i < count; i++) {
+            minimized = minimized || states[i] == app->netWmStateHidden;
+        }
+    }
+    if (data) {
+        XFree(data);
+    }
+    app->minimized = minimized && app->netWmStateHidden != None;
+    app->redraw = 1;
+}
+#endif
+
+// Translate one X event into the event queue, returns 0 if the app should quit (Escape).
+static int translateEvent(SApplication *app, XEvent *xevent) {
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+
+#ifdef STDUI_XSHM
+    if (app->shmCompletion != 0 && xevent->type == app->shmCompletion) {
+        releaseSoftwareBuffer(app, ((XShmCompletionEvent*)xevent)->shmseg);
+        return 1;
+    }
+#endif
+
+    switch (xevent->type) {
+        case Expose:
+            // Only handle expose if it's the last one in the queue, the next frame repaints.
+            if (xevent->xexpose.count == 0) {
+                app->redraw = 1;
+            }
+            return 1;
+        case KeyPress:
+        case KeyRelease:
+            event.type = xevent->type == KeyPress ? SEVENT_KEY_PRESS : SEVENT_KEY_RELEASE;
+            event.key = (unsigned int)XLookupKeysym(&xevent->xkey, 0);
+            event.modifiers = translateModifiers(xevent->xkey.state);
+            event.time = (unsigned long)xevent->xkey.time;
+            noteInputTime(&app->latency, event.time);
+            recordEvent(&app->events, &app->input, &event);
+            app->redraw = 1;
+            return !(xevent->type == KeyPress && event.key == XK_Escape);
+        case ButtonPress: //Button down. (mouse)
+        case ButtonRelease: //Button up.  (mouse)
+            event.x = (float)xevent->xbutton.x;
+            event.y = (float)xevent->xbutton.y;
+            event.modifiers = translateModifiers(xevent->xbutton.state);
+            event.time = (unsigned long)xevent->xbutton.time;
+            if (!translateButton(&event, xevent->type == ButtonPress, xevent->xbutton.button)) {
+                return 1;
+            }
+            break;
+        case MotionNotify:
+            event.type = SEVENT_MOTION;
+            event.x = (float)xevent->xmotion.x;
+            event.y = (float)xevent->xmotion.y;
+            event.modifiers = translateModifiers(xevent->xmotion.state);
+            event.time = (unsigned long)xevent->xmotion.time;
+            break;
+#ifdef STDUI_XINPUT2
+        case GenericEvent: {
+            // Cookies carry no window, the event data says which one it is for.
+            Window window = None;
+            if (app->xiOpcode == 0 || xevent->xcookie.extension != app->xiOpcode ||
+                !translateXIEvent(app, &xevent->xcookie, &event, &window)) {
+                return 1;
+            }
+            SApplication *owner = findWindow(window);
+            if (owner) {
+                app = owner;
+                beginInput(&app->input);
+            }
+            break;
+        }
+#endif
+        case ConfigureNotify:
+            if (xevent->xconfigure.width == app->width && xevent->xconfigure.height == app->height) {
+                return 1; // Moved, not resized.
+            }
+            app->width = xevent->xconfigure.width;
+            app->height = xevent->xconfigure.height;
+            event.type = SEVENT_RESIZE;
+            event.width = app->width;
+            event.height = app->height;
+            break;
+        case FocusIn:
+        case FocusOut:
+            event.type = xevent->type == FocusIn ? SEVENT_FOCUS_IN : SEVENT_FOCUS_OUT;
+            break;
+        // Visibility only changes what SBeginFrame() does, a redraw catches up once shown again.
+        case MapNotify:
+        case UnmapNotify:
+            app->mapped = xevent->type == MapNotify;
+            app->redraw = 1;
+            return 1;
+        case VisibilityNotify:
+            app->obscured = xevent->xvisibility.state == VisibilityFullyObscured;
+            app->redraw = 1;
+            return 1;
+        case PropertyNotify:
+            if (xevent->xproperty.atom == app->netWmState) {
+                requestMinimizedState(app);
+            }
+            return 1;
+        case ClientMessage:
+            // Handle window close events (WM_DELETE_WINDOW)
+            if ((Atom)xevent->xclient.data.l[0] != app->wmDeleteWindow) {
+                return 1;
+            }
+            event.type = SEVENT_CLOSE;
+            event.time = (unsigned long)xevent->xclient.data.l[1];
+            break;
+        default:
+            return 1;
+    }
+
+    if (event.time != 0 && event.type != SEVENT_CLOSE) {
+        noteInputTime(&app->latency, event.time);
+    }
+    recordEvent(&app->events, &app->input, &event);
+    app->redraw = 1;
+    return 1;
+}
+
+#ifdef STDUI_USE_XCB
+// Window an XCB event is for, 0 for types this file does not handle.
+static Window xcbEventWindow(const xcb_generic_event_t *xevent) {
+    switch (xevent->response_type & ~0x80) {
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE:
+            return ((const xcb_key_press_event_t*)xevent)->event;
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE:
+            return ((const xcb_button_press_event_t*)xevent)->event;
+        case XCB_MOTION_NOTIFY:
+            return ((const xcb_motion_notify_event_t*)xevent)->event;
+        case XCB_EXPOSE:
+            return ((const xcb_expose_event_t*)xevent)->window;
+        case XCB_CONFIGURE_NOTIFY:
+            return ((const xcb_configure_notify_event_t*)xevent)->window;
+        case XCB_MAP_NOTIFY:
+            return ((const xcb_map_notify_event_t*)xevent)->window;
+        case XCB_UNMAP_NOTIFY:
+            return ((const xcb_unmap_notify_event_t*)xevent)->window;
+        case XCB_VISIBILITY_NOTIFY:
+            return ((const xcb_visibility_notify_event_t*)xevent)->window;
+        case XCB_PROPERTY_NOTIFY:
+            return ((const xcb_property_notify_event_t*)xevent)->window;
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+            return ((const xcb_focus_in_event_t*)xevent)->event;
+        case XCB_CLIENT_MESSAGE:
+            return ((const xcb_client_message_event_t*)xevent)->window;
+        default:
+            return 0;
+    }
+}
+
+// translateEvent() for XCB events, returns 0 if the app should quit (Escape).
+static int translateXcbEvent(SApplication *app, const xcb_generic_event_t *xevent) {
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+
+    switch (xevent->response_type & ~0x80) {
+        case 0: {
+            const xcb_generic_error_t *error = (const xcb_generic_error_t*)xevent;
+            fprintf(stderr, "ERROR: X request %d failed with error %d.\n", error->major_code, error->error_code);
+            return 1;
+        }
+        case XCB_EXPOSE:
+            if (((const xcb_expose_event_t*)xevent)->count == 0) {
+                app->redraw = 1;
+            }
+            return 1;
+        case XCB_KEY_PRESS:
+        case XCB_KEY_RELEASE: {
+            const xcb_key_press_event_t *key = (const xcb_key_press_event_t*)xevent;
+            event.type = (xevent->response_type & ~0x80) == XCB_KEY_PRESS ? SEVENT_KEY_PRESS : SEVENT_KEY_RELEASE;
+            // Xlib keeps the keyboard map after the first lookup, later ones stay local.
+            event.key = (unsigned int)XkbKeycodeToKeysym(app->display, key->detail, 0, 0);
+            event.modifiers = translateModifiers(key->state);
+            event.time = (unsigned long)key->time;
+            noteInputTime(&app->latency, event.time);
+            recordEvent(&app->events, &app->input, &event);
+            app->redraw = 1;
+            return !(event.type == SEVENT_KEY_PRESS && event.key == XK_Escape);
+        }
+        case XCB_BUTTON_PRESS:
+        case XCB_BUTTON_RELEASE: {
+            const xcb_button_press_event_t *button = (const xcb_button_press_event_t*)xevent;
+            event.x = (float)button->event_x;
+            event.y = (float)button->event_y;
+            event.modifiers = translateModifiers(button->state);
+            event.time = (unsigned long)button->time;
+            if (!translateButton(&event, (xevent->response_type & ~0x80) == XCB_BUTTON_PRESS, button->detail)) {
+                return 1;
+            }
+            break;
+        }
+        case XCB_MOTION_NOTIFY: {
+            const xcb_motion_notify_event_t *motion = (const xcb_motion_notify_event_t*)xevent;
+            event.type = SEVENT_MOTION;
+            event.x = (float)motion->event_x;
+            event.y = (float)motion->event_y;
+            event.modifiers = translateModifiers(motion->state);
+            event.time = (unsigned long)motion->time;
+            break;
+        }
+        case XCB_CONFIGURE_NOTIFY: {
+            const xcb_configure_notify_event_t *configure = (const xcb_configure_notify_event_t*)xevent;
+            if (configure->width == app->width && configure->height == app->height) {
+                return 1; // Moved, not resized.
+            }
+            app->width = configure->width;
+            app->height = configure->height;
+            event.type = SEVENT_RESIZE;
+            event.width = app->width;
+            event.height = app->height;
+            break;
+        }
+        case XCB_FOCUS_IN:
+        case XCB_FOCUS_OUT:
+            event.type = (xevent->response_type & ~0x80) == XCB_FOCUS_IN ? SEVENT_FOCUS_IN : SEVENT_FOCUS_OUT;
+            break;
+        case XCB_MAP_NOTIFY:
+        case XCB_UNMAP_NOTIFY:
+            app->mapped = (xevent->response_type & ~0x80) == XCB_MAP_NOTIFY;
+            app->redraw = 1;
+            return 1;
+        case XCB_VISIBILITY_NOTIFY:
+            app->obscured = ((const xcb_visibility_notify_event_t*)xevent)->state == XCB_VISIBILITY_FULLY_OBSCURED;
+            app->redraw = 1;
+            return 1;
+        case XCB_PROPERTY_NOTIFY:
+            if (((const xcb_property_notify_event_t*)xevent)->atom == (xcb_atom_t)app->netWmState) {
+                requestMinimizedState(app);
+            }
+            return 1;
+        case XCB_CLIENT_MESSAGE: {
+            const xcb_client_message_event_t *message = (const xcb_client_message_event_t*)xevent;
+            if ((Atom)message->data.data32[0] != app->wmDeleteWindow) {
+                return 1;
+            }
+            event.type = SEVENT_CLOSE;
+            event.time = (unsigned long)message->data.data32[1];
+            break;
+        }
+        default:
+            return 1;
+    }
+
+    if (event.time != 0 && event.type != SEVENT_CLOSE) {
+        noteInputTime(&app->latency, event.time);
+    }
+    recordEvent(&app->events, &app->input, &event);
+    app->redraw = 1;
+    return 1;
+}
+
+// Route every event read so far to the queue of the window it is for. One non-blocking read
+// from the socket, the rest of the batch comes from XCB's queue.
+static void drainEvents(SApplication *app) {
+    xcb_generic_event_t *xevent = xcbPendingEvent ? xcbPendingEvent : xcb_poll_for_event(app->connection);
+    xcbPendingEvent = NULL;
+    while (xevent) {
+        SApplication *target = findWindow(xcbEventWindow(xevent));
+        if (target == NULL) {
+            target = app;
+        }
+        beginInput(&target->input);
+        if (!translateXcbEvent(target, xevent)) {
+            target->input.closeRequested = true;
+        }
+        if (target != app) {
+            SGetMouseState(target);
+        }
+        free(xevent);
+        xevent = xcb_poll_for_queued_event(app->connection);
+    }
+    for (int i = 0; i < stduiWindowCount; i++) {
+        pollMinimizedState(stduiWindows[i]);
+    }
+}
+#else
+// Route every X event read so far to the queue of the window it is for.
+static void drainEvents(SApplication *app) {
+    // XPending reads whatever the server has sent so far, after that the events come
+    // straight from Xlib's queue without touching the connection again.
+    XPending(app->display);
+    while (XQLength(app->display) > 0) {
+        XNextEvent(app->display, &app->event);
+        SApplication *target = findWindow(app->event.xany.window);
+        if (target == NULL) {
+            target = app;
+        }
+        beginInput(&target->input);
+        if (!translateEvent(target, &app->event)) {
+            target->input.closeRequested = true;
+        }
+        if (target != app) {
+            SGetMouseState(target);
+        }
+    }
+    for (int i = 0; i < stduiWindowCount; i++) {
+        pollMinimizedState(stduiWindows[i]);
+    }
 }
+#endif
 
+// Drain every pending X event into the event queue of the window it is for. Returns 0 once
+// this window was closed or Escape pressed in it.
 int SEventProcess(SApplication *app) {
     if (app == NULL || app->display == NULL) {
         return 0;
@@ -310,69 +3252,133 @@ int SEventProcess(SApplication *app) {
     #ifdef STDUI_VERBAL_DEBUG
     printf("STATUS: Started processing events.\n");
     #endif
-    
-    if (XPending(app->display) > 0) {
-        XNextEvent(app->display, &app->event);
-        switch (app->event.type) {
-            case Expose:
-                // Only handle expose if it's the last one in the queue
-                if (app->event.xexpose.count == 0) {
-                    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-                }
-                break;
-            case KeyPress:
-                if (XLookupKeysym(&app->event.xkey, 0) == XK_Escape) {
-                    return 0;
-                }
-                break;
-            case ButtonPress: //Button down. (mouse)
-                if (app->event.xbutton.button == Button1) {
-                    app->mouseDown = 1;
-                    app->mouseX = (float)app->event.xbutton.x;
-                    app->mouseY = (float)app->event.xbutton.y;
-                }
-                break;
-            case ButtonRelease: //Button up.  (mouse)
-                if (app->event.xbutton.button == Button1) {
-                    app->mouseDown = 0;
-                }
-                break;
-            case MotionNotify:
-                // Compress motion events
-                while (XCheckTypedWindowEvent(app->display, app->window, MotionNotify, &app->event)) {
-                    // Just get the latest position
-                }
-                app->mouseX = (float)app->event.xmotion.x;
-                app->mouseY = (float)app->event.xmotion.y;
-                break;
-            case ClientMessage:
-                // Handle window close events (WM_DELETE_WINDOW)
-                // Would need to set up the atom first, not implemented here
-                break;
+
+    beginInput(&app->input);
+    drainEvents(app);
+    if (advanceInputLog(&app->events, &app->input)) {
+        app->redraw = 1;
+    }
+    SGetMouseState(app);
+    app->input.delivered = true;
+    return !app->input.closeRequested;
+}
+
+// Sleep until an X event arrives, SPostEmptyEvent() is called or timeout seconds pass
+// (negative waits forever), then drain events like SEventProcess(). A timeout counts as a
+// timer tick and requests a redraw. Use instead of SEventProcess() to idle at zero CPU.
+// Glyph workers wake the window that last drew text, see SGetPendingGlyphCount().
+int SWaitEvents(SApplication *app, double timeout) {
+    if (app == NULL || app->display == NULL) {
+        return 0;
+    }
+
+    // A replay runs flat out, every call is one frame of the log.
+    if (app->inputLog.replaying) {
+        app->redraw = 1;
+    }
+
+#ifdef STDUI_USE_XCB
+    // Replies can pull events off the socket without it polling readable, check the queue first.
+    xcb_flush(app->connection);
+    if (!app->redraw && xcbPendingEvent == NULL) {
+        xcbPendingEvent = xcb_poll_for_queued_event(app->connection);
+    }
+    if (!app->redraw && xcbPendingEvent == NULL) {
+#else
+    // XPending also flushes our requests, which the server must see before we sleep.
+    if (!app->redraw && XPending(app->display) == 0) {
+#endif
+        struct pollfd fds[2] = {
+            { ConnectionNumber(app->display), POLLIN, 0 },
+            { app->wakeFd, POLLIN, 0 }
+        };
+        if (windowHidden(app)) {
+            timeout = hiddenWaitTimeout(timeout);
+        }
+        int timeoutMs = timeout < 0.0 ? -1 : (int)(timeout * 1000.0 + 0.5);
+        int ready;
+        do {
+            ready = poll(fds, app->wakeFd >= 0 ? 2 : 1, timeoutMs);
+        } while (ready < 0 && errno == EINTR);
+
+        if (ready == 0) {
+            app->redraw = 1;
+        } else if (ready < 0) {
+            fprintf(stderr, "ERROR: Waiting for events failed.\n");
+        }
+
+        if (app->wakeFd >= 0 && (fds[1].revents & POLLIN)) {
+            uint64_t count;
+            if (read(app->wakeFd, &count, sizeof(count)) < 0) {
+                // Nothing to clear, another wait already read it.
+            }
         }
     }
-    
-    return 1;
+
+    return SEventProcess(app);
+}
+
+// Wake a thread blocked in SWaitEvents(). Safe to call from any thread.
+void SPostEmptyEvent(SApplication *app) {
+    if (app == NULL || app->wakeFd < 0) {
+        return;
+    }
+    uint64_t one = 1;
+    if (write(app->wakeFd, &one, sizeof(one)) < 0) {
+        fprintf(stderr, "ERROR: Failed to wake the event loop.\n");
+    }
 }
 
 void SDisplayClose(SApplication *app) {
     if (app == NULL) {
         return;
     }
+    closeInputLog(&app->events);
+    releaseGlyphWake(app);
     
 
     
-    #ifdef IMAGE_H
-    // Cleanup image renderer if it exists
-    if (imageRenderer) {
-        imageRenderer = NULL;
-    }
-    #endif
  
-    if (app->glx_context) {
-        glXMakeCurrent(app->display, None, NULL);
-        glXDestroyContext(app->display, app->glx_context);
-        app->glx_context = NULL;
+#ifdef STDUI_USE_XCB
+    if (app->stateChanged) {
+        xcb_discard_reply(app->connection, app->stateRequest.sequence);
+        app->stateChanged = false;
+    }
+#endif
+    int index = -1;
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i] == app) {
+            index = i;
+        }
+    }
+
+    if (hasContext(app)) {
+        makeContextCurrent(app);
+        SDeleteContextObjects(&app->contextObjects);
+        // The shared objects go with the last context of the group.
+        int contexts = 0;
+        for (int i = 0; i < stduiWindowCount; i++) {
+            contexts += hasContext(stduiWindows[i]);
+        }
+        if (index >= 0 && contexts == 1) {
+            SCleanupTextRenderer();
+            SCleanupRenderer();
+        }
+        destroyContext(app);
+    }
+
+    if (index >= 0) {
+        stduiWindows[index] = stduiWindows[--stduiWindowCount];
+        stduiWindows[stduiWindowCount] = NULL;
+    }
+
+    // Only software windows have a GC and framebuffers.
+    if (app->gc) {
+        for (int i = 0; i < 2; i++) {
+            freeSoftwareBuffer(app, &app->softwareBuffers[i]);
+        }
+        XFreeGC(app->display, app->gc);
+        app->gc = NULL;
     }
     
     if (app->window) {
@@ -384,88 +3390,200 @@ void SDisplayClose(SApplication *app) {
         XFreeColormap(app->display, app->colormap);
         app->colormap = 0;
     }
-    
+
+    if (app->wakeFd >= 0) {
+        close(app->wakeFd);
+        app->wakeFd = -1;
+    }
+
     if (app->display) {
-        XCloseDisplay(app->display);
+        if (--sharedDisplayUsers == 0) {
+            #ifdef STDUI_USE_XCB
+            free(xcbPendingEvent);
+            xcbPendingEvent = NULL;
+            #endif
+            #ifdef STDUI_GLES
+            if (sharedEglDisplay != EGL_NO_DISPLAY) {
+                eglTerminate(sharedEglDisplay);
+                sharedEglDisplay = EGL_NO_DISPLAY;
+            }
+            #endif
+            XCloseDisplay(sharedDisplay);
+            sharedDisplay = NULL;
+        }
         app->display = NULL;
     }
 }
 
-static inline void SClearScreen(SApplication *app, float r, float g, float b) {
-    glClearColor(r, g, b, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-    
-    // Note: Using fixed-function pipeline with OpenGL 3.3 context
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+static inline void SClearScreen(SApplication *app, float r, float g, float b) {
+    glClearColor(r, g, b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+}
+
+
+
+// The shaders take the projection as a uniform, see applyWindowSize(). The fixed-function
+// matrix stack does not exist in the core profile or in GLES.
+void SUpdateViewport(SApplication *app, int width, int height) {
+    if (width <= 0 || height <= 0) {
+        return; // Avoid setting invalid viewport dimensions
+    }
+
+    glViewport(0, 0, width, height);
+}
+
+// Update the viewport and the shape projection when the window size changed since the last frame.
+static inline void applyWindowSize(SApplication *app) {
+    if (app->width <= 0 || app->height <= 0 ||
+        (app->width == app->viewportWidth && app->height == app->viewportHeight)) {
+        return;
+    }
+
+    SUpdateViewport(app, app->width, app->height);
+    glUseProgram(renderer.basicProgram);
+    setOrthographicProjection(renderer.basicProgram, app->width, app->height);
+    app->viewportWidth = app->width;
+    app->viewportHeight = app->height;
+}
+
+// Make this window's context current and point the draw functions at its objects. Programs
+// are shared, so the shape projection is set again for this window's size.
+void SMakeCurrent(SApplication *app) {
+    if (app == NULL || app->display == NULL || !hasContext(app)) {
+        return;
+    }
+    makeContextCurrent(app);
+    SUseContextObjects(&app->contextObjects);
+    app->viewportWidth = app->viewportHeight = 0;
+}
+
+// Low-latency mode trades throughput for a shorter click-to-pixels delay:
+// - SBeginFrame() sleeps until just before the next vblank, minus the usual render time, and
+//   drains events again so the frame is built from the newest input.
+// - SEndFrame() waits for the GPU after every swap so no frame queues behind another.
+// - With GLX_OML_sync_control the swap completion time comes from the driver.
+// Latency from the oldest input of a frame to its swap completing goes to SGetLatencyStats().
+bool SSetLowLatency(SApplication *app, bool enable) {
+    if (app == NULL || app->display == NULL || app->window == 0) {
+        return false;
+    }
+
+#ifndef STDUI_GLES
+    app->waitForSbc = NULL;
+    if (enable && strstr(glXQueryExtensionsString(app->display, app->screen), "GLX_OML_sync_control")) {
+        app->waitForSbc = (PFNGLXWAITFORSBCOMLPROC) glXGetProcAddress((const GLubyte*)"glXWaitForSbcOML");
+    }
+#endif
+
+    app->lowLatency = enable;
+    app->renderTime = 0.0;
+    app->lastShown = 0.0;
+    app->latency.pendingInput = 0.0; // Input from before the switch was not measured.
+    return true;
 }
 
+// Sleep until the latest point the frame can start and still make the next vblank, then pick
+// up what arrived meanwhile. The edges of the last SEventProcess() stay, this only adds to them.
+static void sampleInputLate(SApplication *app) {
+    if (app->swapInterval != 0) {
+        waitForLateStart(app->lastShown, app->pacer.refreshRate, app->renderTime);
+    }
+
+    app->frameStart = frameClock();
+    bool delivered = app->input.delivered;
+    app->input.delivered = false;
+    setLateSample(&app->events, true);
+    drainEvents(app);
+    setLateSample(&app->events, false);
+    app->input.delivered = delivered;
+    SGetMouseState(app);
+}
 
+// Called after the swap in low-latency mode: keep one frame in flight and measure latency.
+static void finishLowLatencyFrame(SApplication *app, double submitted) {
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+        glDeleteSync(fence);
+    }
 
-void SUpdateViewport(SApplication *app, int width, int height) {
-    if (width <= 0 || height <= 0) {
-        return; // Avoid setting invalid viewport dimensions
+    double shown = frameClock();
+#ifndef STDUI_GLES
+    int64_t ust, msc, sbc;
+    // Target 0 waits for every queued swap. UST is the monotonic clock in microseconds on
+    // Mesa, anything far off from frameClock() is some other clock and ignored.
+    if (app->waitForSbc && app->waitForSbc(app->display, app->window, 0, &ust, &msc, &sbc) && ust > 0) {
+        double driverShown = (double)ust / 1e6;
+        if (driverShown > shown - 1.0 && driverShown <= shown) {
+            shown = driverShown;
+        }
     }
-    
-    glViewport(0, 0, width, height);
-    
-    // Note: Using fixed-function pipeline with OpenGL 3.3 context (Deprectated..)
+#endif
 
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, width, height, 0, -1, 1); // Origin at top-left.
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+    app->renderTime = averageRenderTime(app->renderTime, submitted - app->frameStart);
+    app->lastShown = shown;
+    recordLatency(&app->latency, shown);
 }
 
-static inline void SBeginFrame(SApplication *app) {
+// Start a frame. Returns false when the window is unmapped, minimized or fully covered: the
+// draw functions do nothing until SEndFrame(), which skips the swap and ticks at
+// STDUI_HIDDEN_FRAME_RATE, so only the app state needs updating.
+static inline bool SBeginFrame(SApplication *app) {
     if (app == NULL || app->display == NULL) {
-        return;
+        return false;
+    }
+
+    if (!contextIsCurrent(app)) {
+        SMakeCurrent(app);
+    }
+
+    app->frameHidden = windowHidden(app);
+    if (app->lowLatency && !app->frameHidden) {
+        sampleInputLate(app);
     }
 
     #ifdef STDUI_VERBAL_DEBUG
     printf("STATUS: Entering Rendering Loop \n");
     #endif
-    
-    int width = SGetCurrentWindowWidth(app);
-    int height = SGetCurrentWindowHeight(app);
-    
-    if (width > 0 && height > 0) {
-        SUpdateViewport(app, width, height);
+
+    // Cleared before drawing, so an SInvalidate() during the frame asks for another one.
+    app->redraw = 0;
+    if (app->frameHidden) {
+        return false;
     }
-    
-    SGetMouseState(app);
+
+    applyWindowSize(app);
         
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
-
-    #ifdef IMAGE_H
-    if (imageRenderer) {
-        renderImage(imageRenderer);
-    }
-    #endif
+    return true;
 }
 
 static inline void SEndFrame(SApplication *app) {
     if (app == NULL || app->display == NULL || app->window == 0) {
         return;
     }
+
+    if (app->frameHidden) {
+        app->frameHidden = false;
+        paceHiddenFrame(&app->pacer);
+        return;
+    }
     
-    glXSwapBuffers(app->display, app->window);
-    // Process any pending X events to keep the UI responsive
-    while (XPending(app->display) > 0) {
-        XEvent event;
-        XNextEvent(app->display, &event);
-        // Handle essential events here if needed
+    double submitted = frameClock();
+    swapWindowBuffers(app);
+    if (app->lowLatency) {
+        finishLowLatencyFrame(app, submitted);
     }
+    paceFrame(&app->pacer);
+    // Events that arrive now are drained by the next SEventProcess() call.
 }
 
 #elif defined(_WIN32) || defined(_WIN64) 
 #include <windows.h>
 #include <GL/gl.h>
+#include <GL/glext.h> // Not part of the Windows SDK, MinGW ships it, otherwise get it from Khronos.
+#include "internal/gl_loader.h"
 //THIS windows code was written with an LLM. No idea what it does. (I hate WIN32 API.)
 
 // Window procedure function prototype
@@ -480,22 +3598,135 @@ typedef struct {
     float mouseX;
     float mouseY;
     int mouseDown;
+    SEventQueue events;
+    SInputState input;
+    volatile int redraw;     // Set by input, SWaitEvents() timeouts and SInvalidate(), cleared by SBeginFrame().
+    int viewportWidth, viewportHeight; // Size the viewport was last set for.
+    int swapInterval;        // Last interval accepted by SSetSwapInterval().
+    SFramePacer pacer;
+    SContextObjects contextObjects;
+    bool lowLatency;         // See SSetLowLatency().
+    bool minimized;          // Between WM_SIZE with SIZE_MINIMIZED and the next restore.
+    bool frameHidden;        // SBeginFrame() found the window hidden, draws are dropped until SEndFrame().
+    double frameStart;       // When SBeginFrame() sampled input, frameClock() seconds.
+    double renderTime;       // Running average from frameStart to the swap being submitted.
+    double lastShown;        // When the GPU finished the last frame.
+    SLatencyTracker latency;
+    SInputLog inputLog;      // See SRecordInput() and SReplayInput().
 } SApplication;
 
+static SApplication *stduiWindows[STDUI_MAX_WINDOWS];
+static int stduiWindowCount = 0;
+
+static bool windowHidden(SApplication *app) {
+    return app->minimized || !IsWindowVisible(app->hwnd);
+}
+
 // Forward declarations
 bool initText(const char* fontPath);
 void SUpdateViewport(SApplication *app, int width, int height);
+void SGetContextObjects(SContextObjects* objects);
+void SUseContextObjects(const SContextObjects* objects);
+void SDeleteContextObjects(SContextObjects* objects);
+void SCleanupTextRenderer();
 
-#ifdef IMAGE_H
-extern ImageRenderer* imageRenderer;
-void renderImage(ImageRenderer* renderer);
-#endif
+static double frameClock(void) {
+    static LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    if (frequency.QuadPart == 0) {
+        QueryPerformanceFrequency(&frequency);
+    }
+    QueryPerformanceCounter(&now);
+    return (double)now.QuadPart / (double)frequency.QuadPart;
+}
+
+static void sleepUntil(double time) {
+    // Sleep is only good to a millisecond or so, spin for the rest.
+    double remaining;
+    while ((remaining = time - frameClock()) > 0.002) {
+        Sleep((DWORD)((remaining - 0.001) * 1000.0));
+    }
+    while (frameClock() < time) {
+    }
+}
+
+static double queryRefreshRate(SApplication *app) {
+    DEVMODE mode;
+    memset(&mode, 0, sizeof(mode));
+    mode.dmSize = sizeof(mode);
+    if (EnumDisplaySettings(NULL, ENUM_CURRENT_SETTINGS, &mode) && mode.dmDisplayFrequency > 1) {
+        return (double)mode.dmDisplayFrequency;
+    }
+    return 60.0;
+}
+
+// Set how many refreshes a swap waits for: 0 is unsynced, 1 is vsync, -1 is adaptive vsync
+// and falls back to 1 where the driver refuses it.
+bool SSetSwapInterval(SApplication *app, int interval) {
+    typedef BOOL (WINAPI *SwapIntervalProc)(int interval);
+    SwapIntervalProc wglSwapIntervalEXT = (SwapIntervalProc)wglGetProcAddress("wglSwapIntervalEXT");
+    if (app == NULL || wglSwapIntervalEXT == NULL) {
+        fprintf(stderr, "ERROR: WGL_EXT_swap_control not available, the swap interval is up to the driver.\n");
+        return false;
+    }
+    if (!wglSwapIntervalEXT(interval)) {
+        if (interval >= 0 || !wglSwapIntervalEXT(1)) {
+            return false;
+        }
+        interval = 1;
+    }
+    app->swapInterval = interval;
+    return true;
+}
+
+// Low-latency mode, see the X11 version. WGL has no swap completion timestamps, the frame
+// counts as shown once the GPU finished it.
+bool SSetLowLatency(SApplication *app, bool enable) {
+    if (app == NULL || app->hdc == NULL) {
+        return false;
+    }
+    app->lowLatency = enable;
+    app->renderTime = 0.0;
+    app->lastShown = 0.0;
+    app->latency.pendingInput = 0.0;
+    return true;
+}
+
+static int pumpMessages(SApplication *app);
+
+static void sampleInputLate(SApplication *app) {
+    if (app->swapInterval != 0) {
+        waitForLateStart(app->lastShown, app->pacer.refreshRate, app->renderTime);
+    }
+
+    app->frameStart = frameClock();
+    setLateSample(&app->events, true);
+    if (!pumpMessages(app)) {
+        PostQuitMessage(0); // Leave it for SEventProcess() to report.
+    }
+    setLateSample(&app->events, false);
+    SGetMouseState(app);
+}
+
+static void finishLowLatencyFrame(SApplication *app, double submitted) {
+    GLsync fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    if (fence) {
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 100000000); // 100 ms
+        glDeleteSync(fence);
+    }
+
+    app->renderTime = averageRenderTime(app->renderTime, submitted - app->frameStart);
+    app->lastShown = frameClock();
+    recordLatency(&app->latency, app->lastShown);
+}
 
 int SDisplayOpen(SApplication *app) {
     if (app == NULL) {
         return 0;
     }
-    
+    // Applications keep this on the stack, state that no window sets up has to start out zero.
+    memset(app, 0, sizeof(*app));
+
     app->hinstance = GetModuleHandle(NULL);
     
     // Register the window class
@@ -507,7 +3738,8 @@ int SDisplayOpen(SApplication *app) {
     wc.lpszClassName = CLASS_NAME;
     wc.style = CS_OWNDC;
     
-    if (!RegisterClass(&wc)) {
+    // Every window after the first finds the class registered already.
+    if (!RegisterClass(&wc) && GetLastError() != ERROR_CLASS_ALREADY_EXISTS) {
         fprintf(stderr, "Failed to register window class.\n");
         return 0;
     }
@@ -524,6 +3756,13 @@ int SWindowCreate(SApplication *app, const char *title, int x, int y, int width,
     app->mouseX = 0.0f;
     app->mouseY = 0.0f;
     app->mouseDown = 0;
+    memset(&app->events, 0, sizeof(app->events));
+    memset(&app->inputLog, 0, sizeof(app->inputLog));
+    memset(&app->input, 0, sizeof(app->input));
+    app->redraw = 1;
+    app->viewportWidth = app->viewportHeight = 0;
+    app->minimized = false;
+    app->frameHidden = false;
 
     app->hwnd = CreateWindowEx(
         0,                          // Optional window styles
@@ -580,46 +3819,96 @@ int SWindowCreate(SApplication *app, const char *title, int x, int y, int width,
     }
     
 
+    if (stduiWindowCount >= STDUI_MAX_WINDOWS) {
+        fprintf(stderr, "ERROR: Too many windows (max %d)\n", STDUI_MAX_WINDOWS);
+        return 0;
+    }
+
     app->hglrc = wglCreateContext(app->hdc);
     if (app->hglrc == NULL) {
         fprintf(stderr, "Failed to create OpenGL context.\n");
         return 0;
     }
+
+    // Join the share group of the windows that already exist, before anything is created in it.
+    if (stduiWindowCount > 0 && !wglShareLists(stduiWindows[0]->hglrc, app->hglrc)) {
+        fprintf(stderr, "ERROR: Failed to share GL objects with the other windows.\n");
+        wglDeleteContext(app->hglrc);
+        app->hglrc = NULL;
+        return 0;
+    }
     
 
     if (!wglMakeCurrent(app->hdc, app->hglrc)) {
         fprintf(stderr, "Failed to make OpenGL context current.\n");
         return 0;
     }
-    
+
+    // Sync to the monitor unless the application asks otherwise.
+    SSetSwapInterval(app, 1);
+    initFramePacer(&app->pacer, queryRefreshRate(app));
+
     // Enable blending for text
     glEnable(GL_BLEND);
     glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
     
     // Initialize text rendering
-    if (!initText("stdui/internal/courier_new.ttf")) {
+    if (!initText(NULL)) {
         fprintf(stderr, "ERROR: Failed to initialize text rendering.\n");
         return 0;
     }
 
+    SGetContextObjects(&app->contextObjects);
+    stduiWindows[stduiWindowCount++] = app;
+
     ShowWindow(app->hwnd, SW_SHOW);
     UpdateWindow(app->hwnd);
     
     return 1;
 }
 
+// Copy the pointer state tracked from messages into mouseX, mouseY and mouseDown. A left click
+// that started and ended since the last drain still reads as down for that frame.
 void SGetMouseState(SApplication *app) {
     if (app == NULL) {
         return;
     }
-    
-    POINT point;
-    if (GetCursorPos(&point) && ScreenToClient(app->hwnd, &point)) {
-        app->mouseX = (float)point.x;
-        app->mouseY = (float)point.y;
+
+    app->mouseX = app->input.mouseX;
+    app->mouseY = app->input.mouseY;
+    app->mouseDown = ((app->input.buttons | app->input.pressed) & 1) ? 1 : 0;
+}
+
+static unsigned int currentModifiers(void) {
+    unsigned int modifiers = 0;
+    if (GetKeyState(VK_SHIFT) & 0x8000)   modifiers |= SMOD_SHIFT;
+    if (GetKeyState(VK_CONTROL) & 0x8000) modifiers |= SMOD_CONTROL;
+    if (GetKeyState(VK_MENU) & 0x8000)    modifiers |= SMOD_ALT;
+    if ((GetKeyState(VK_LWIN) | GetKeyState(VK_RWIN)) & 0x8000) modifiers |= SMOD_SUPER;
+    if (GetKeyState(VK_CAPITAL) & 1)      modifiers |= SMOD_CAPS_LOCK;
+    if (GetKeyState(VK_NUMLOCK) & 1)      modifiers |= SMOD_NUM_LOCK;
+    return modifiers;
+}
+
+// Drain every pending message, WindowProc queues the events. Returns 0 on WM_QUIT.
+static int pumpMessages(SApplication *app) {
+    while (PeekMessage(&app->msg, NULL, 0, 0, PM_REMOVE)) {
+        if (app->msg.message == WM_QUIT) {
+            return 0;
+        }
+
+        // WM_NULL is what SPostEmptyEvent() sends, it only wakes the loop.
+        if (app->msg.message != WM_NULL) {
+            app->redraw = 1;
+        }
+        if ((app->msg.message >= WM_KEYFIRST && app->msg.message <= WM_KEYLAST) ||
+            (app->msg.message >= WM_MOUSEFIRST && app->msg.message <= WM_MOUSELAST)) {
+            noteInputTime(&app->latency, (unsigned long)app->msg.time);
+        }
+        TranslateMessage(&app->msg);
+        DispatchMessage(&app->msg);
     }
-    
-    app->mouseDown = (GetAsyncKeyState(VK_LBUTTON) & 0x8000) ? 1 : 0;
+    return 1;
 }
 
 int SEventProcess(SApplication *app) {
@@ -628,29 +3917,79 @@ int SEventProcess(SApplication *app) {
     }
     
 
-    if (PeekMessage(&app->msg, NULL, 0, 0, PM_REMOVE)) {
- 
-        if (app->msg.message == WM_QUIT) {
-            return 0;
+    resetInputEdges(&app->input);
+    if (!pumpMessages(app)) {
+        return 0;
+    }
+    if (advanceInputLog(&app->events, &app->input)) {
+        app->redraw = 1;
+    }
+
+    SGetMouseState(app);
+    return !app->input.closeRequested;
+}
+
+// Sleep until a message arrives, SPostEmptyEvent() is called or timeout seconds pass
+// (negative waits forever), then drain messages like SEventProcess(). A timeout counts as a
+// timer tick and requests a redraw.
+int SWaitEvents(SApplication *app, double timeout) {
+    if (app == NULL) {
+        return 0;
+    }
+
+    if (app->inputLog.replaying) {
+        app->redraw = 1;
+    }
+
+    if (!app->redraw) {
+        if (windowHidden(app)) {
+            timeout = hiddenWaitTimeout(timeout);
+        }
+        DWORD timeoutMs = timeout < 0.0 ? INFINITE : (DWORD)(timeout * 1000.0 + 0.5);
+        if (MsgWaitForMultipleObjects(0, NULL, FALSE, timeoutMs, QS_ALLINPUT) == WAIT_TIMEOUT) {
+            app->redraw = 1;
         }
-        
-        TranslateMessage(&app->msg);
-        DispatchMessage(&app->msg);
     }
-    
-    return 1;
+
+    return SEventProcess(app);
+}
+
+// Wake a thread blocked in SWaitEvents(). Safe to call from any thread.
+void SPostEmptyEvent(SApplication *app) {
+    if (app == NULL || app->hwnd == NULL) {
+        return;
+    }
+    PostMessage(app->hwnd, WM_NULL, 0, 0);
 }
 
 void SDisplayClose(SApplication *app) {
     if (app == NULL) {
         return;
     }
-    
+    closeInputLog(&app->events);
+
+
+    int index = -1;
+    for (int i = 0; i < stduiWindowCount; i++) {
+        if (stduiWindows[i] == app) {
+            index = i;
+        }
+    }
 
     if (app->hglrc) {
+        wglMakeCurrent(app->hdc, app->hglrc);
+        SDeleteContextObjects(&app->contextObjects);
+        if (index >= 0 && stduiWindowCount == 1) {
+            SCleanupTextRenderer();
+        }
         wglMakeCurrent(NULL, NULL);
         wglDeleteContext(app->hglrc);
     }
+
+    if (index >= 0) {
+        stduiWindows[index] = stduiWindows[--stduiWindowCount];
+        stduiWindows[stduiWindowCount] = NULL;
+    }
     
 
     if (app->hwnd && app->hdc) {
@@ -661,8 +4000,10 @@ void SDisplayClose(SApplication *app) {
     if (app->hwnd) {
         DestroyWindow(app->hwnd);
     }
-    
-    UnregisterClass("OpenGLWindowClass", app->hinstance);
+
+    if (stduiWindowCount == 0) {
+        UnregisterClass("OpenGLWindowClass", app->hinstance);
+    }
 }
 
 static inline int SGetCurrentWindowWidth(SApplication *app) {
@@ -711,35 +4052,67 @@ static inline void SClearScreen(SApplication *app, float r, float g, float b) {
     glLoadIdentity();
 }
 
-static inline void SBeginFrame(SApplication *app) {
+// Make this window's context current and point the draw functions at its objects.
+void SMakeCurrent(SApplication *app) {
+    if (app == NULL || app->hglrc == NULL) {
+        return;
+    }
+    wglMakeCurrent(app->hdc, app->hglrc);
+    SUseContextObjects(&app->contextObjects);
+    app->viewportWidth = app->viewportHeight = 0;
+}
+
+// Start a frame. Returns false while the window is minimized, see the X11 version.
+static inline bool SBeginFrame(SApplication *app) {
+    if (app == NULL || app->hdc == NULL) {
+        return false;
+    }
+    if (wglGetCurrentContext() != app->hglrc) {
+        SMakeCurrent(app);
+    }
+    app->frameHidden = windowHidden(app);
+    if (app->lowLatency && !app->frameHidden) {
+        sampleInputLate(app);
+    }
+    app->redraw = 0;
+    if (app->frameHidden) {
+        return false;
+    }
+
     int width = SGetCurrentWindowWidth(app);
     int height = SGetCurrentWindowHeight(app);
-    
-    if (width > 0 && height > 0) {
+
+    if (width > 0 && height > 0 && (width != app->viewportWidth || height != app->viewportHeight)) {
         SUpdateViewport(app, width, height);
+        app->viewportWidth = width;
+        app->viewportHeight = height;
     }
-    
-    SGetMouseState(app);
         
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
     glMatrixMode(GL_MODELVIEW);
     glLoadIdentity();
-
-    #ifdef IMAGE_H
-    if (imageRenderer) {
-        renderImage(imageRenderer);
-    }
-    #endif
+    return true;
 }
 
 static inline void SEndFrame(SApplication *app) {
     if (app == NULL || app->hdc == NULL) {
         return;
     }
-    
+
+    if (app->frameHidden) {
+        app->frameHidden = false;
+        paceHiddenFrame(&app->pacer);
+        return;
+    }
+
+    double submitted = frameClock();
     SwapBuffers(app->hdc);
+    if (app->lowLatency) {
+        finishLowLatencyFrame(app, submitted);
+    }
+    paceFrame(&app->pacer);
 }
 
 // Store a pointer to the application instance to access in WindowProc
@@ -748,7 +4121,16 @@ SApplication* g_app = NULL;
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     // Try to get the app instance from window user data
     SApplication* app = (SApplication*)GetWindowLongPtr(hwnd, GWLP_USERDATA);
-    
+    if (!app && uMsg != WM_CREATE) {
+        app = g_app;
+    }
+
+    SEvent event;
+    memset(&event, 0, sizeof(event));
+    // GetKeyState follows the message queue, so this is the state when the message was posted.
+    event.time = (unsigned long)GetMessageTime();
+    event.modifiers = currentModifiers();
+
     switch (uMsg) {
         case WM_CREATE: {
             // Save the app pointer passed in CreateWindow
@@ -762,43 +4144,87 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
         }
         
         case WM_CLOSE:
+            if (app) {
+                event.type = SEVENT_CLOSE;
+                recordEvent(&app->events, &app->input, &event);
+            }
             PostQuitMessage(0);
             return 0;
             
         case WM_KEYDOWN:
-            if (wParam == VK_ESCAPE) {
+        case WM_KEYUP:
+            if (app) {
+                event.type = uMsg == WM_KEYDOWN ? SEVENT_KEY_PRESS : SEVENT_KEY_RELEASE;
+                event.key = (unsigned int)wParam;
+                recordEvent(&app->events, &app->input, &event);
+            }
+            if (uMsg == WM_KEYDOWN && wParam == VK_ESCAPE) {
                 PostQuitMessage(0);
                 return 0;
             }
             break;
             
         case WM_LBUTTONDOWN:
+        case WM_LBUTTONUP:
+        case WM_MBUTTONDOWN:
+        case WM_MBUTTONUP:
+        case WM_RBUTTONDOWN:
+        case WM_RBUTTONUP:
             if (app) {
-                app->mouseDown = 1;
-                app->mouseX = (float)LOWORD(lParam);
-                app->mouseY = (float)HIWORD(lParam);
-            } else if (g_app) {
-                g_app->mouseDown = 1;
-                g_app->mouseX = (float)LOWORD(lParam);
-                g_app->mouseY = (float)HIWORD(lParam);
+                event.type = (uMsg == WM_LBUTTONDOWN || uMsg == WM_MBUTTONDOWN || uMsg == WM_RBUTTONDOWN)
+                           ? SEVENT_BUTTON_PRESS : SEVENT_BUTTON_RELEASE;
+                event.button = (uMsg == WM_LBUTTONDOWN || uMsg == WM_LBUTTONUP) ? 1 :
+                               (uMsg == WM_MBUTTONDOWN || uMsg == WM_MBUTTONUP) ? 2 : 3;
+                event.x = (float)(short)LOWORD(lParam);
+                event.y = (float)(short)HIWORD(lParam);
+                recordEvent(&app->events, &app->input, &event);
             }
             break;
             
-        case WM_LBUTTONUP:
+        case WM_MOUSEMOVE:
             if (app) {
-                app->mouseDown = 0;
-            } else if (g_app) {
-                g_app->mouseDown = 0;
+                event.type = SEVENT_MOTION;
+                event.x = (float)(short)LOWORD(lParam);
+                event.y = (float)(short)HIWORD(lParam);
+                recordEvent(&app->events, &app->input, &event);
             }
             break;
-            
-        case WM_MOUSEMOVE:
+
+        case WM_MOUSEWHEEL:
+        case WM_MOUSEHWHEEL:
+            if (app) {
+                // Wheel messages carry screen coordinates.
+                POINT point = { (short)LOWORD(lParam), (short)HIWORD(lParam) };
+                ScreenToClient(hwnd, &point);
+                float steps = (float)GET_WHEEL_DELTA_WPARAM(wParam) / WHEEL_DELTA;
+                event.type = SEVENT_SCROLL;
+                event.x = (float)point.x;
+                event.y = (float)point.y;
+                if (uMsg == WM_MOUSEWHEEL) event.scrollY = steps; else event.scrollX = steps;
+                recordEvent(&app->events, &app->input, &event);
+            }
+            return 0;
+
+        case WM_SIZE:
+            if (app) {
+                if (app->minimized != (wParam == SIZE_MINIMIZED)) {
+                    app->redraw = 1;
+                }
+                app->minimized = wParam == SIZE_MINIMIZED;
+            }
+            if (app && wParam != SIZE_MINIMIZED) {
+                event.type = SEVENT_RESIZE;
+                event.width = LOWORD(lParam);
+                event.height = HIWORD(lParam);
+                recordEvent(&app->events, &app->input, &event);
+            }
+            break;
+
+        case WM_SETFOCUS:
+        case WM_KILLFOCUS:
             if (app) {
-                app->mouseX = (float)LOWORD(lParam);
-                app->mouseY = (float)HIWORD(lParam);
-            } else if (g_app) {
-                g_app->mouseX = (float)LOWORD(lParam);
-                g_app->mouseY = (float)HIWORD(lParam);
+                event.type = uMsg == WM_SETFOCUS ? SEVENT_FOCUS_IN : SEVENT_FOCUS_OUT;
+                recordEvent(&app->events, &app->input, &event);
             }
             break;
             
@@ -814,3 +4240,117 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 #include <ApplicationServices/ApplicationServices.h>
 //TODO: MACOS :sob:
 #endif
+
+#if defined(__linux__) || defined(_WIN32) || defined(_WIN64)
+// Take the oldest event drained by SEventProcess(), false once the queue is empty.
+bool SPollEvent(SApplication *app, SEvent *event) {
+    if (app == NULL || event == NULL) {
+        return false;
+    }
+    return dequeueEvent(&app->events, event);
+}
+
+// Pointer, buttons, wheel and focus after the events drained so far.
+const SInputState* SGetInputState(SApplication *app) {
+    return app ? &app->input : NULL;
+}
+
+// Ask for a redraw from any thread, wakes SWaitEvents() if it is sleeping.
+void SInvalidate(SApplication *app) {
+    if (app == NULL) {
+        return;
+    }
+    app->redraw = 1;
+    SPostEmptyEvent(app);
+}
+
+// True when something changed since the last SBeginFrame(): input, a SWaitEvents() timeout
+// or SInvalidate(). Skip the frame when false to keep an idle window at zero CPU.
+bool SNeedsRedraw(SApplication *app) {
+    return app != NULL && app->redraw;
+}
+
+// False while the window is unmapped, minimized or fully covered. SBeginFrame() returns the same
+// and drops the frame's draws, this is for skipping other work meanwhile.
+bool SWindowVisible(SApplication *app) {
+    return app != NULL && !windowHidden(app);
+}
+
+// Cap the frame rate, SEndFrame() sleeps until the frame is due. 0 turns the limiter off and a
+// negative value caps at the monitor refresh rate, for when vsync is off or ignored.
+void SSetFrameLimit(SApplication *app, double fps) {
+    if (app == NULL) {
+        return;
+    }
+    if (fps < 0.0) {
+        fps = app->pacer.refreshRate;
+    }
+    app->pacer.limit = fps > 0.0 ? 1.0 / fps : 0.0;
+    app->pacer.deadline = 0.0;
+}
+
+double SGetRefreshRate(SApplication *app) {
+    return app ? app->pacer.refreshRate : 0.0;
+}
+
+SFrameStats SGetFrameStats(SApplication *app) {
+    SFrameStats stats;
+    if (app == NULL) {
+        memset(&stats, 0, sizeof(stats));
+        return stats;
+    }
+    return frameStats(&app->pacer);
+}
+
+// Input-to-photon latency histogram, filled while low-latency mode is on.
+SLatencyStats SGetLatencyStats(SApplication *app) {
+    SLatencyStats stats;
+    if (app == NULL) {
+        memset(&stats, 0, sizeof(stats));
+        return stats;
+    }
+    return latencyStats(&app->latency);
+}
+
+void SResetLatencyStats(SApplication *app) {
+    if (app == NULL) {
+        return;
+    }
+    memset(&app->latency, 0, sizeof(app->latency));
+}
+
+// Write every input event from now on to path, tagged with the SEventProcess() call it was
+// drained in. Stops with SStopInputLog() or when the window closes.
+bool SRecordInput(SApplication *app, const char *path) {
+    if (app == NULL) {
+        return false;
+    }
+    return openInputLog(&app->events, &app->inputLog, path, false);
+}
+
+// Feed a log from SRecordInput() back, each event on the same SEventProcess() call counted from
+// now. Live input is ignored and SWaitEvents() does not sleep until the log runs out, so a
+// replay under Xvfb repeats the same frames every run.
+bool SReplayInput(SApplication *app, const char *path) {
+    if (app == NULL) {
+        return false;
+    }
+    if (!openInputLog(&app->events, &app->inputLog, path, true)) {
+        return false;
+    }
+    app->redraw = 1;
+    return true;
+}
+
+void SStopInputLog(SApplication *app) {
+    if (app == NULL) {
+        return;
+    }
+    closeInputLog(&app->events);
+}
+
+// True until a replay has fed its last event, use it to end a benchmark run.
+bool SInputReplaying(SApplication *app) {
+    return app != NULL && app->inputLog.replaying;
+}
+#endif